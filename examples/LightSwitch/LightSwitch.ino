@@ -52,6 +52,17 @@
 
 #define VISIBILITY_TIMEOUT 90	// Define how long the WRF should act as a Access Point
 
+// Sizes of the JsonBuffers, computed from the shape of the messages instead of guessed.
+// extras/BufferSize prints them for a sample message.
+// parseObject(String) copies the text in the buffer, so it needs room for it too.
+#define LIGHT_MESSAGE_MAX_LENGTH 64		// {"power":true}
+#define LIGHT_MESSAGE_BUFFER_SIZE (JSON_OBJECT_SIZE(2) + JSON_STRING_SIZE(LIGHT_MESSAGE_MAX_LENGTH))
+#define STATUS_MAX_MEMBERS 8
+#define STATUS_MAX_LENGTH 256			// {"connection_status":"GOT_IP","local_visibility":"OFF",...}
+#define STATUS_BUFFER_SIZE (JSON_OBJECT_SIZE(STATUS_MAX_MEMBERS) + JSON_STRING_SIZE(STATUS_MAX_LENGTH))
+// {"com.devicedrive.light":{"status":"Off","power":0}}, the state String is copied
+#define SEND_STATUS_BUFFER_SIZE (JSON_OBJECT_SIZE(1) + JSON_OBJECT_SIZE(2) + JSON_STRING_SIZE(sizeof(TEXT_OFF) - 1))
+
 WRF wrf(
 	&Serial1,					// Communication port to the WRF, baud 115200
 	VERSION,					// Version of your code,it's used to determine if you need an OTA upgrade. Please itereate this number accordingly.
@@ -72,7 +83,7 @@ typedef void ButtonPressCallback();
 ButtonPressCallback *button_press_cb = NULL;
 ButtonPressCallback *button_long_press_cb = NULL;
 bool button_was_pressed; // previous state
-int button_pressed_counter; // press running duration
+unsigned long button_pressed_since; // millis() when the press started
 void onButtonPress(ButtonPressCallback * callback);
 void onButtonLongPress(ButtonPressCallback * callback);
 
@@ -110,9 +121,16 @@ void setup() {
 }
 
 void loop() {
-  wrf.loopHandler();	// Polls new messages and triggers event handlers
-  handle_button();		// Handels the pins set for buttons and triggers event handlers	
-  delay(1);
+  unsigned long idle = wrf.loopHandler();	// Polls new messages, triggers event handlers, and returns the ms until it needs to run again
+  handle_button();		// Handels the pins set for buttons and triggers event handlers
+
+  // Nothing to do until then, unless the WRF sends something or the button changes
+  unsigned long start = millis();
+  while (millis() - start < idle && !Serial1.available() && (!digitalRead(PUSH_PIN)) == button_was_pressed) {
+#if defined(ARDUINO_ARCH_SAMD)
+    __WFI();	// sleeps until the next interrupt: the serial port, or the tick of millis()
+#endif
+  }
 }
 
 void handleError(String error_msg) {
@@ -158,7 +176,7 @@ void handleMessage(String interface_name, String json_string) {
 	// When we recive a message with our interface we handle it
 	if (interface_name == INTERFACE_NAME)
 	{
-		StaticJsonBuffer<200> jsonBuffer;
+		StaticJsonBuffer<LIGHT_MESSAGE_BUFFER_SIZE> jsonBuffer;
 		JsonObject& light_interface = jsonBuffer.parseObject(json_string);
 		if (light_interface.containsKey(POWER_PARAM))
 		{
@@ -193,7 +211,7 @@ void handleUpgrades(List &pending_upgrades) {
 
 void handleWRFStatus(String interface_name, String json_string) {
 	Serial.println("Status Received");
-	StaticJsonBuffer<512> buffer;
+	StaticJsonBuffer<STATUS_BUFFER_SIZE> buffer;
 	JsonObject& status = buffer.parseObject(json_string.c_str());
 
 	if (status.containsKey(STATUS_VISIBILITY)) {
@@ -204,7 +222,7 @@ void handleWRFStatus(String interface_name, String json_string) {
 }
 
 void sendStatus() {
-	StaticJsonBuffer<200> jsonBuffer;
+	StaticJsonBuffer<SEND_STATUS_BUFFER_SIZE> jsonBuffer;
 	JsonObject& status = jsonBuffer.createObject();
 	JsonObject& params = status.createNestedObject(INTERFACE_NAME);
 	params[STATUS_PARAM] = state;
@@ -256,10 +274,11 @@ void onButtonLongPress(ButtonPressCallback * callback) {
 void handle_button()
 {
   int button_now_pressed = !digitalRead(PUSH_PIN); // pin low -> pressed
+  unsigned long button_pressed_duration = millis() - button_pressed_since;
   // Trigger current event
   if (!button_now_pressed && button_was_pressed) {
-    if (button_pressed_counter < LONGPRESS) {
-      if (button_pressed_counter > SHORTPRESS) {
+    if (button_pressed_duration < LONGPRESS) {
+      if (button_pressed_duration > SHORTPRESS) {
 		  if(button_press_cb != NULL)
 			button_press_cb();
       }
@@ -269,10 +288,8 @@ void handle_button()
     }
   } 
   // Tracking button push
-  if (button_now_pressed) {
-    button_pressed_counter++;
-  } else {
-    button_pressed_counter = 0;
+  if (button_now_pressed && !button_was_pressed) {
+    button_pressed_since = millis();
   }
   button_was_pressed = button_now_pressed;
 }
@@ -0,0 +1,200 @@
+/*	Copyright 2016 DeviceDrive AS
+*
+*	Licensed under the Apache License, Version 2.0 (the "License");
+*	you may not use this file except in compliance with the License.
+*	You may obtain a copy of the License at
+*
+*	http ://www.apache.org/licenses/LICENSE-2.0
+*
+*	Unless required by applicable law or agreed to in writing, software
+*	distributed under the License is distributed on an "AS IS" BASIS,
+*	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*	See the License for the specific language governing permissions and
+*	limitations under the License.
+*
+*/
+
+// Prints the capacity of the StaticJsonBuffer needed for a sample document,
+// on the Arduino Zero (SAMD21) and on a 64-bit computer.
+//
+// This is a tool for the computer, not for the Arduino:
+//
+//	g++ -I../../src/ArduinoJson -o BufferSize BufferSize.cpp
+//	./BufferSize sample.json
+
+#include <stdio.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "ArduinoJson.h"
+
+#define SAMPLE_NESTING_LIMIT 50
+
+// What JSON_ARRAY_SIZE(), JSON_OBJECT_SIZE() and JSON_STRING_SIZE() give on
+// each platform
+struct Layout {
+	const char *name;
+	size_t container;	// sizeof(JsonArray), same as sizeof(JsonObject)
+	size_t element;		// sizeof(JsonArray::node_type)
+	size_t member;		// sizeof(JsonObject::node_type)
+	size_t alignment;	// strings are rounded up to this
+};
+
+static const Layout layouts[] = {
+	{ "SAMD21", 8, 12, 16, 4 },	// 32-bit pointers, float and long in JsonVariant
+	{ "host", 16, 24, 32, 8 },	// 64-bit pointers, double and long long
+};
+#define LAYOUT_COUNT (sizeof(layouts) / sizeof(layouts[0]))
+#define HOST_LAYOUT 1
+
+struct Shape {
+	std::map<size_t, int> objects;	// number of objects of each size
+	std::map<size_t, int> arrays;
+	size_t members = 0;
+	size_t elements = 0;
+	std::vector<size_t> strings;	// length of each key and string value
+};
+
+static void measure(JsonVariant value, Shape &shape)
+{
+	if (value.is<JsonObject&>()) {
+		JsonObject &object = value.as<JsonObject&>();
+		shape.objects[object.size()]++;
+		shape.members += object.size();
+		for (JsonObject::iterator it = object.begin(); it != object.end(); ++it) {
+			shape.strings.push_back(strlen(it->key));
+			measure(it->value, shape);
+		}
+	}
+	else if (value.is<JsonArray&>()) {
+		JsonArray &array = value.as<JsonArray&>();
+		shape.arrays[array.size()]++;
+		shape.elements += array.size();
+		for (JsonArray::iterator it = array.begin(); it != array.end(); ++it)
+			measure(*it, shape);
+	}
+	else if (value.is<const char*>() && value.as<const char*>() != NULL) {
+		shape.strings.push_back(strlen(value.as<const char*>()));
+	}
+}
+
+static size_t count(const std::map<size_t, int> &containers)
+{
+	size_t total = 0;
+	for (std::map<size_t, int>::const_iterator it = containers.begin(); it != containers.end(); ++it)
+		total += it->second;
+	return total;
+}
+
+static size_t stringSize(size_t length, const Layout &layout)
+{
+	return (length + layout.alignment) & ~(layout.alignment - 1);
+}
+
+static size_t nodesSize(const Shape &shape, const Layout &layout)
+{
+	return (count(shape.objects) + count(shape.arrays)) * layout.container +
+		shape.members * layout.member + shape.elements * layout.element;
+}
+
+static size_t stringsSize(const Shape &shape, const Layout &layout)
+{
+	size_t total = 0;
+	for (size_t i = 0; i < shape.strings.size(); i++)
+		total += stringSize(shape.strings[i], layout);
+	return total;
+}
+
+// e.g. "JSON_OBJECT_SIZE(1) + 3 * JSON_OBJECT_SIZE(2)"
+static std::string expression(const std::map<size_t, int> &containers, const char *macro)
+{
+	std::string result;
+	for (std::map<size_t, int>::const_iterator it = containers.begin(); it != containers.end(); ++it) {
+		if (!result.empty())
+			result += " + ";
+		if (it->second > 1)
+			result += std::to_string(it->second) + " * ";
+		result += std::string(macro) + "(" + std::to_string(it->first) + ")";
+	}
+	return result;
+}
+
+static bool readFile(const char *path, std::string &content)
+{
+	FILE *file = fopen(path, "rb");
+	if (file == NULL)
+		return false;
+	char chunk[512];
+	size_t n;
+	while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0)
+		content.append(chunk, n);
+	fclose(file);
+	return true;
+}
+
+// The host layout is the one of this computer, if it's a 64-bit one
+static void checkHostLayout()
+{
+	const Layout &host = layouts[HOST_LAYOUT];
+	if (sizeof(void*) != 8)
+		return;
+	if (sizeof(JsonArray) != host.container || sizeof(JsonObject) != host.container ||
+		sizeof(JsonArray::node_type) != host.element || sizeof(JsonObject::node_type) != host.member)
+		fprintf(stderr, "Warning: the layout of this computer doesn't match the \"%s\" column\n", host.name);
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc != 2) {
+		fprintf(stderr, "Usage: %s sample.json\n", argv[0]);
+		return 1;
+	}
+
+	std::string json;
+	if (!readFile(argv[1], json)) {
+		fprintf(stderr, "Cannot read %s\n", argv[1]);
+		return 1;
+	}
+
+	DynamicJsonBuffer buffer;
+	JsonVariant root = buffer.parse(json.c_str(), SAMPLE_NESTING_LIMIT);
+	if (!root.is<JsonObject&>() && !root.is<JsonArray&>()) {
+		fprintf(stderr, "%s doesn't contain a JSON object or array\n", argv[1]);
+		return 1;
+	}
+	checkHostLayout();
+
+	Shape shape;
+	measure(root, shape);
+
+	size_t characters = 0;
+	for (size_t i = 0; i < shape.strings.size(); i++)
+		characters += shape.strings[i];
+	printf("%s: %zu objects with %zu members, %zu arrays with %zu elements, %zu strings with %zu characters\n\n",
+		argv[1], count(shape.objects), shape.members, count(shape.arrays), shape.elements,
+		shape.strings.size(), characters);
+
+	printf("%-40s", "");
+	for (size_t i = 0; i < LAYOUT_COUNT; i++)
+		printf("%8s", layouts[i].name);
+	printf("\n%-40s", "parseObject(char*)");
+	for (size_t i = 0; i < LAYOUT_COUNT; i++)
+		printf("%8zu", nodesSize(shape, layouts[i]));
+	printf("\n%-40s", "parseObject(const char*) or (String)");
+	for (size_t i = 0; i < LAYOUT_COUNT; i++)
+		printf("%8zu", nodesSize(shape, layouts[i]) + stringSize(json.size(), layouts[i]));
+	printf("\n%-40s", "with a copy of each key and string");
+	for (size_t i = 0; i < LAYOUT_COUNT; i++)
+		printf("%8zu", nodesSize(shape, layouts[i]) + stringsSize(shape, layouts[i]));
+
+	std::string nodes = expression(shape.objects, "JSON_OBJECT_SIZE");
+	std::string arrays = expression(shape.arrays, "JSON_ARRAY_SIZE");
+	if (!nodes.empty() && !arrays.empty())
+		nodes += " + ";
+	nodes += arrays;
+	printf("\n\nWith parseObject(char*), that is:\n\tStaticJsonBuffer<%s>\n", nodes.c_str());
+	printf("Add JSON_STRING_SIZE(length) for the copy of the input made by parseObject(const char*),\n"
+		"or for each string copied in the buffer.\n");
+	return 0;
+}
@@ -0,0 +1,129 @@
+/*	Copyright 2016 DeviceDrive AS
+*
+*	Licensed under the Apache License, Version 2.0 (the "License");
+*	you may not use this file except in compliance with the License.
+*	You may obtain a copy of the License at
+*
+*	http ://www.apache.org/licenses/LICENSE-2.0
+*
+*	Unless required by applicable law or agreed to in writing, software
+*	distributed under the License is distributed on an "AS IS" BASIS,
+*	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*	See the License for the specific language governing permissions and
+*	limitations under the License.
+*
+*/
+
+// Crc32 against a bitwise CRC-32, for every length up to a few folds and
+// every alignment. The Makefile builds it with slicing-by-4, slicing-by-8
+// and, with PCLMULQDQ, the folding kernel.
+
+#include <stdlib.h>
+#include "Crc32.h"
+#include "HostTest.h"
+
+#define DATA_SIZE 4200
+
+static uint8_t data[DATA_SIZE + 16];
+
+static uint32_t referenceCrc(const uint8_t *bytes, size_t size)
+{
+	uint32_t crc = 0xffffffff;
+	while (size--) {
+		crc ^= *bytes++;
+		for (int bit = 0; bit < 8; bit++)
+			crc = (crc & 1) ? (crc >> 1) ^ 0xedb88320 : crc >> 1;
+	}
+	return ~crc;
+}
+
+static uint32_t crcOf(const uint8_t *bytes, size_t size)
+{
+	Crc32 crc;
+	crc.update(bytes, size);
+	return crc.value();
+}
+
+static void testKnownValue()
+{
+	CHECK(crcOf((const uint8_t *)"123456789", 9) == 0xcbf43926);
+	CHECK(crcOf(data, 0) == 0);
+}
+
+static void testLengthsAndAlignments()
+{
+	for (size_t offset = 0; offset < 16; offset++) {
+		for (size_t size = 0; size <= 300; size++)
+			CHECK(crcOf(data + offset, size) == referenceCrc(data + offset, size));
+	}
+	static const size_t long_sizes[] = { 511, 512, 1024, 1031, 4096, DATA_SIZE };
+	for (size_t offset = 0; offset < 16; offset++) {
+		for (size_t i = 0; i < sizeof(long_sizes) / sizeof(long_sizes[0]); i++)
+			CHECK(crcOf(data + offset, long_sizes[i]) == referenceCrc(data + offset, long_sizes[i]));
+	}
+}
+
+// The same result, whatever the pieces the data arrives in
+static void testPieces()
+{
+	uint32_t expected = referenceCrc(data, 1500);
+	Crc32 crc;
+	for (size_t offset = 0; offset < 1500; ) {
+		size_t size = 1 + (offset * 7) % 97;
+		if (offset + size > 1500)
+			size = 1500 - offset;
+		if (size == 1)
+			crc.update(data[offset]);
+		else
+			crc.update(data + offset, size);
+		offset += size;
+	}
+	CHECK(crc.value() == expected);
+	CHECK(crc.length() == 1500);
+}
+
+static void testCombine()
+{
+	static const size_t splits[] = { 0, 1, 3, 15, 16, 64, 100, 512, 999, 1000 };
+	uint32_t expected = referenceCrc(data, 1000);
+	for (size_t i = 0; i < sizeof(splits) / sizeof(splits[0]); i++) {
+		size_t split = splits[i];
+		uint32_t first = referenceCrc(data, split);
+		uint32_t second = referenceCrc(data + split, 1000 - split);
+		CHECK(Crc32::combine(first, second, 1000 - split) == expected);
+	}
+
+	// the chunks of an image, joined in order
+	uint32_t crc = 0;
+	for (size_t offset = 0; offset < DATA_SIZE; offset += 512) {
+		size_t size = DATA_SIZE - offset < 512 ? DATA_SIZE - offset : 512;
+		crc = Crc32::combine(crc, referenceCrc(data + offset, size), size);
+	}
+	CHECK(crc == referenceCrc(data, DATA_SIZE));
+}
+
+int main()
+{
+#if defined(__PCLMUL__)
+	if (!__builtin_cpu_supports("pclmul")) {
+		printf("Crc32Test: skipped, no PCLMULQDQ\n");
+		return 0;
+	}
+#endif
+	srand(1);
+	for (size_t i = 0; i < sizeof(data); i++)
+		data[i] = rand();
+
+	testKnownValue();
+	testLengthsAndAlignments();
+	testPieces();
+	testCombine();
+
+	char name[32];
+#if defined(__PCLMUL__)
+	snprintf(name, sizeof(name), "Crc32Test (folding)");
+#else
+	snprintf(name, sizeof(name), "Crc32Test (slicing-by-%d)", CRC32_SLICES);
+#endif
+	return testResult(name);
+}
@@ -0,0 +1,316 @@
+/*	Copyright 2016 DeviceDrive AS
+*
+*	Licensed under the Apache License, Version 2.0 (the "License");
+*	you may not use this file except in compliance with the License.
+*	You may obtain a copy of the License at
+*
+*	http ://www.apache.org/licenses/LICENSE-2.0
+*
+*	Unless required by applicable law or agreed to in writing, software
+*	distributed under the License is distributed on an "AS IS" BASIS,
+*	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*	See the License for the specific language governing permissions and
+*	limitations under the License.
+*
+*/
+
+// DeltaPatch against patches built here: each operation, with the patch cut
+// in pieces and the new image produced in windows of several sizes, and the
+// patches it must refuse.
+
+#include <stdlib.h>
+#include "DeltaPatch.h"
+#include "HostTest.h"
+
+#define CURRENT_SIZE 1000
+#define TARGET_MAX_SIZE 2000
+#define PATCH_MAX_SIZE 2000
+
+// with room for the operations past its end, that the patches refuse
+static uint8_t current[CURRENT_SIZE + 16];
+static uint8_t patch[PATCH_MAX_SIZE];
+static size_t patch_size;
+static uint8_t expected[TARGET_MAX_SIZE];
+static size_t expected_size;
+static uint8_t target[TARGET_MAX_SIZE];
+static size_t target_size;
+
+// The image that runs now
+class CurrentImage : public ImageStorage
+{
+	public:
+		virtual bool begin(size_t size, bool resume) { return true; }
+		virtual int write(size_t offset, const uint8_t *data, size_t size) { return size; }
+		virtual bool end() { return true; }
+
+		virtual size_t readCurrent(size_t offset, uint8_t *data, size_t size)
+		{
+			if (offset > CURRENT_SIZE)
+				return 0;
+			if (size > CURRENT_SIZE - offset)
+				size = CURRENT_SIZE - offset;
+			memcpy(data, current + offset, size);
+			return size;
+		}
+};
+
+static void putByte(uint8_t data)
+{
+	patch[patch_size++] = data;
+}
+
+static void putWord(uint32_t word)
+{
+	for (int i = 0; i < 4; i++)
+		putByte(word >> (8 * i));
+}
+
+static void putVarint(uint32_t number)
+{
+	while (number >= 0x80) {
+		putByte(number | 0x80);
+		number >>= 7;
+	}
+	putByte(number);
+}
+
+static void startPatch(uint32_t size, uint32_t crc)
+{
+	patch_size = 0;
+	expected_size = 0;
+	putWord(DELTA_MAGIC);
+	putWord(CURRENT_SIZE);
+	putWord(0x12345678);
+	putWord(size);
+	putWord(crc);
+}
+
+static void copy(uint32_t source, uint32_t length)
+{
+	putByte(DELTA_COPY);
+	putVarint(source);
+	putVarint(length);
+	memcpy(expected + expected_size, current + source, length);
+	expected_size += length;
+}
+
+static void add(uint32_t source, uint32_t length)
+{
+	putByte(DELTA_ADD);
+	putVarint(source);
+	putVarint(length);
+	for (uint32_t i = 0; i < length; i++) {
+		uint8_t difference = i * 3 + 1;
+		putByte(difference);
+		expected[expected_size++] = current[source + i] + difference;
+	}
+}
+
+static void insert(uint32_t length)
+{
+	putByte(DELTA_INSERT);
+	putVarint(length);
+	for (uint32_t i = 0; i < length; i++) {
+		putByte(0xa0 + i);
+		expected[expected_size++] = 0xa0 + i;
+	}
+}
+
+// Gives the patch in pieces of piece_size bytes, keeping what wasn't used
+// for the next call, as the WRF class does. The new image goes to target
+static void applyPatch(DeltaPatch &delta, size_t piece_size, size_t window_size)
+{
+	static CurrentImage image;
+	uint8_t window[TARGET_MAX_SIZE];
+	size_t given = 0;
+	size_t used = 0;
+	target_size = 0;
+
+	delta.begin(&image);
+	while (!delta.failed()) {
+		size_t length;
+		size_t count = delta.apply(patch + used, given - used, window, window_size, &length);
+		CHECK(length <= window_size);
+		if (target_size + length > TARGET_MAX_SIZE)
+			break;
+		memcpy(target + target_size, window, length);
+		target_size += length;
+		used += count;
+		if (count == 0 && length == 0) {
+			if (given == patch_size)
+				break;
+			given = given + piece_size < patch_size ? given + piece_size : patch_size;
+		}
+	}
+}
+
+static bool targetMatches()
+{
+	return target_size == expected_size && memcmp(target, expected, expected_size) == 0;
+}
+
+static void testOperations()
+{
+	static const size_t piece_sizes[] = { 1, 2, 3, 7, 64, PATCH_MAX_SIZE };
+	static const size_t window_sizes[] = { 1, 2, 5, 64, 256, TARGET_MAX_SIZE };
+
+	// the operations cross the windows and the pieces anywhere
+	startPatch(0, 0);
+	copy(10, 300);
+	add(500, 200);
+	insert(150);
+	copy(0, 1);
+	add(999, 1);
+	insert(1);
+	copy(700, 300);
+	patch[12] = expected_size;
+	patch[13] = expected_size >> 8;
+
+	for (size_t p = 0; p < sizeof(piece_sizes) / sizeof(piece_sizes[0]); p++) {
+		for (size_t w = 0; w < sizeof(window_sizes) / sizeof(window_sizes[0]); w++) {
+			DeltaPatch delta;
+			applyPatch(delta, piece_sizes[p], window_sizes[w]);
+			CHECK(!delta.failed());
+			CHECK(delta.finished());
+			CHECK(targetMatches());
+		}
+	}
+}
+
+static void testHeader()
+{
+	startPatch(1, 0xcafebabe);
+	insert(1);
+	DeltaPatch delta;
+	CurrentImage image;
+	uint8_t window[16];
+	size_t length;
+
+	// a truncated header waits for the rest
+	delta.begin(&image);
+	CHECK(delta.apply(patch, DELTA_HEADER_SIZE - 1, window, sizeof(window), &length) == DELTA_HEADER_SIZE - 1);
+	CHECK(length == 0);
+	CHECK(!delta.hasHeader());
+	CHECK(!delta.failed());
+
+	// it stops after the header
+	CHECK(delta.apply(patch + DELTA_HEADER_SIZE - 1, patch_size - DELTA_HEADER_SIZE + 1, window, sizeof(window), &length) == 1);
+	CHECK(delta.hasHeader());
+	CHECK(delta.sourceSize() == CURRENT_SIZE);
+	CHECK(delta.sourceCrc() == 0x12345678);
+	CHECK(delta.targetSize() == 1);
+	CHECK(delta.targetCrc() == 0xcafebabe);
+
+	// a patch that ends early isn't finished
+	CHECK(delta.apply(patch + DELTA_HEADER_SIZE, 2, window, sizeof(window), &length) == 2);
+	CHECK(length == 0);
+	CHECK(!delta.finished());
+	CHECK(!delta.failed());
+
+	patch[0] ^= 1;
+	applyPatch(delta, PATCH_MAX_SIZE, sizeof(window));
+	CHECK(delta.failed());
+}
+
+// Each patch is refused before anything is produced past the new image
+static void checkRefused(const char *name)
+{
+	DeltaPatch delta;
+	applyPatch(delta, 3, 64);
+	if (!delta.failed())
+		printf("not refused: %s\n", name);
+	CHECK(delta.failed());
+	CHECK(target_size <= expected_size);
+}
+
+static void testBounds()
+{
+	startPatch(100, 0);
+	copy(CURRENT_SIZE - 10, 11);
+	checkRefused("copy past the current image");
+
+	startPatch(100, 0);
+	putByte(DELTA_COPY);
+	putVarint(CURRENT_SIZE + 1);
+	putVarint(0);
+	checkRefused("copy from past the current image");
+
+	startPatch(100, 0);
+	add(CURRENT_SIZE - 5, 6);
+	checkRefused("add past the current image");
+
+	startPatch(100, 0);
+	copy(0, 101);
+	checkRefused("copy past the new image");
+
+	startPatch(100, 0);
+	insert(50);
+	insert(51);
+	checkRefused("insert past the new image");
+
+	startPatch(10, 0);
+	insert(10);
+	insert(1);
+	checkRefused("operation after the new image");
+
+	startPatch(10, 0);
+	putByte(0x04);
+	checkRefused("unknown operation");
+}
+
+// A length has at most 32 bits: the fifth byte of a varint holds the 4 high
+// bits, and must end it
+static void testVarint()
+{
+	static const uint8_t longest[] = { 0x83, 0x80, 0x80, 0x80, 0x00 };
+	static const uint8_t too_large[] = { 0x83, 0x80, 0x80, 0x80, 0x10 };
+	static const uint8_t too_long[] = { 0x83, 0x80, 0x80, 0x80, 0x80, 0x00 };
+
+	startPatch(3, 0);
+	putByte(DELTA_INSERT);
+	memcpy(patch + patch_size, longest, sizeof(longest));
+	patch_size += sizeof(longest);
+	putByte(1);
+	putByte(2);
+	putByte(3);
+	DeltaPatch delta;
+	applyPatch(delta, 1, 64);
+	CHECK(delta.finished());
+	CHECK(target_size == 3 && target[2] == 3);
+
+	// would be 3, once the bit shifted out of 32 bits is lost
+	startPatch(3, 0);
+	putByte(DELTA_INSERT);
+	memcpy(patch + patch_size, too_large, sizeof(too_large));
+	patch_size += sizeof(too_large);
+	putByte(1);
+	putByte(2);
+	putByte(3);
+	checkRefused("varint of more than 32 bits");
+
+	startPatch(3, 0);
+	putByte(DELTA_INSERT);
+	memcpy(patch + patch_size, too_long, sizeof(too_long));
+	patch_size += sizeof(too_long);
+	checkRefused("varint of 6 bytes");
+
+	startPatch(3, 0);
+	putByte(DELTA_COPY);
+	memcpy(patch + patch_size, too_large, sizeof(too_large));
+	patch_size += sizeof(too_large);
+	putVarint(3);
+	checkRefused("source of more than 32 bits");
+}
+
+int main()
+{
+	srand(1);
+	for (size_t i = 0; i < sizeof(current); i++)
+		current[i] = rand();
+
+	testOperations();
+	testHeader();
+	testBounds();
+	testVarint();
+	return testResult("DeltaPatchTest");
+}
@@ -0,0 +1,152 @@
+/*	Copyright 2016 DeviceDrive AS
+*
+*	Licensed under the Apache License, Version 2.0 (the "License");
+*	you may not use this file except in compliance with the License.
+*	You may obtain a copy of the License at
+*
+*	http ://www.apache.org/licenses/LICENSE-2.0
+*
+*	Unless required by applicable law or agreed to in writing, software
+*	distributed under the License is distributed on an "AS IS" BASIS,
+*	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*	See the License for the specific language governing permissions and
+*	limitations under the License.
+*
+*/
+
+// The floats of a JsonVariant keep their number of decimals in the type
+// of the variant. Built with -fshort-enums, as arm-none-eabi does, the type
+// is a single byte: every kind of float must still be read back as a float.
+
+#include "ArduinoJson.h"
+#include "HostTest.h"
+
+using namespace ArduinoJson;
+
+static void print(const JsonVariant &variant, char *text, size_t size)
+{
+	variant.printTo(text, size);
+}
+
+static void testShortestVariant()
+{
+	char text[32];
+	JsonVariant variant = double_with_shortest_digits(0.1);
+	CHECK(variant.is<double>());
+	CHECK(!variant.is<JsonObject&>());
+	CHECK(variant.as<double>() == 0.1);
+	print(variant, text, sizeof(text));
+	CHECK_STRING(text, "0.1");
+
+	variant = float_with_shortest_digits(2.5f);
+	print(variant, text, sizeof(text));
+	CHECK_STRING(text, "2.5");
+}
+
+static void testShortestInContainers()
+{
+	StaticJsonBuffer<200> buffer;
+	JsonObject &object = buffer.createObject();
+	object["pi"] = double_with_shortest_digits(3.14159);
+	JsonArray &array = object.createNestedArray("values");
+	array.add(double_with_shortest_digits(1.25));
+	array.add(1.25, 3);
+
+	char text[64];
+	object.printTo(text, sizeof(text));
+	CHECK_STRING(text, "{\"pi\":3.14159,\"values\":[1.25,1.250]}");
+}
+
+// Too many decimals are clamped, they used to overflow the type
+static void testManyDecimals()
+{
+	char text[32];
+	JsonVariant variant(0.5, 200);
+	CHECK(variant.is<double>());
+	print(variant, text, sizeof(text));
+	CHECK_STRING(text, "0.500000000000000");
+}
+
+// Every number of decimals up to FLOAT_MAX_DECIMALS is written as is
+static void testFixedDecimals()
+{
+	char text[32];
+	char expected[32] = "0.5";
+	print(double_with_n_digits(0.5, 0), text, sizeof(text));
+	CHECK_STRING(text, "1");
+	for (uint8_t decimals = 1; decimals <= Internals::FLOAT_MAX_DECIMALS; decimals++) {
+		print(double_with_n_digits(0.5, decimals), text, sizeof(text));
+		CHECK_STRING(text, expected);
+		strcat(expected, "0");
+	}
+}
+
+// A float member is written with the digits of the float, not of the double
+// it converts to
+struct Reading {
+	float value;
+	double precise;
+};
+
+static void testSchemaFloat()
+{
+	auto schema = makeJsonSchema(
+		jsonField("value", &Reading::value),
+		jsonField("precise", &Reading::precise));
+	Reading reading = { 0.1f, 0.1 };
+	char text[64];
+	schema.printTo(reading, text, sizeof(text));
+	CHECK_STRING(text, "{\"value\":0.1,\"precise\":0.1}");
+
+	reading.value = -3.4028235e38f;
+	schema.printTo(reading, text, sizeof(text));
+	CHECK_STRING(text, "{\"value\":-3.4028235e38,\"precise\":0.1}");
+
+	Reading parsed = {};
+	CHECK(schema.parse("{\"value\":0.1,\"precise\":0.1}", parsed));
+	CHECK(parsed.value == 0.1f);
+	CHECK(parsed.precise == 0.1);
+}
+
+static void testParsedFloat()
+{
+	char json[] = "[0.1,-2.5e3]";
+	StaticJsonBuffer<100> buffer;
+	JsonArray &array = buffer.parseArray(json);
+	CHECK(array.success());
+	CHECK(array[0].as<double>() == 0.1);
+
+	char text[32];
+	array.printTo(text, sizeof(text));
+	CHECK_STRING(text, "[0.1,-2500]");
+}
+
+static void testMsgPackFloat()
+{
+	// float 32 and float 64 of 0.1
+	const uint8_t single[] = { 0xca, 0x3d, 0xcc, 0xcc, 0xcd };
+	const uint8_t twice[] = { 0xcb, 0x3f, 0xb9, 0x99, 0x99, 0x99, 0x99, 0x99, 0x9a };
+	StaticJsonBuffer<100> buffer;
+	char text[32];
+
+	JsonVariant variant = buffer.parseMsgPack(single, sizeof(single));
+	CHECK(variant.is<double>());
+	CHECK(variant.as<float>() == 0.1f);
+
+	variant = buffer.parseMsgPack(twice, sizeof(twice));
+	CHECK(variant.is<double>());
+	print(variant, text, sizeof(text));
+	CHECK_STRING(text, "0.1");
+}
+
+int main()
+{
+	testShortestVariant();
+	testShortestInContainers();
+	testManyDecimals();
+	testFixedDecimals();
+	testSchemaFloat();
+	testParsedFloat();
+	testMsgPackFloat();
+	return testResult("FloatTest");
+}
@@ -0,0 +1,46 @@
+/*	Copyright 2016 DeviceDrive AS
+*
+*	Licensed under the Apache License, Version 2.0 (the "License");
+*	you may not use this file except in compliance with the License.
+*	You may obtain a copy of the License at
+*
+*	http ://www.apache.org/licenses/LICENSE-2.0
+*
+*	Unless required by applicable law or agreed to in writing, software
+*	distributed under the License is distributed on an "AS IS" BASIS,
+*	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*	See the License for the specific language governing permissions and
+*	limitations under the License.
+*
+*/
+
+#pragma once
+#include <stdio.h>
+#include <string.h>
+
+// The checks of the host tests: a failed check is printed and counted, and
+// the test returns the count, so that make stops on it.
+
+static int test_failures = 0;
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			printf("%s:%d: failed: %s\n", __FILE__, __LINE__, #condition); \
+			test_failures++; \
+		} \
+	} while (0)
+
+#define CHECK_STRING(actual, expected) \
+	do { \
+		if (strcmp((actual), (expected)) != 0) { \
+			printf("%s:%d: got \"%s\", expected \"%s\"\n", __FILE__, __LINE__, (actual), (expected)); \
+			test_failures++; \
+		} \
+	} while (0)
+
+static int testResult(const char *name)
+{
+	printf("%s: %s\n", name, test_failures == 0 ? "ok" : "FAILED");
+	return test_failures != 0;
+}
@@ -0,0 +1,71 @@
+/*	Copyright 2016 DeviceDrive AS
+*
+*	Licensed under the Apache License, Version 2.0 (the "License");
+*	you may not use this file except in compliance with the License.
+*	You may obtain a copy of the License at
+*
+*	http ://www.apache.org/licenses/LICENSE-2.0
+*
+*	Unless required by applicable law or agreed to in writing, software
+*	distributed under the License is distributed on an "AS IS" BASIS,
+*	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*	See the License for the specific language governing permissions and
+*	limitations under the License.
+*
+*/
+
+// JsonStreamParser accepts the same nesting as JsonBuffer::parseArray() and
+// parseObject() for each nesting limit.
+
+#include "ArduinoJson.h"
+#include "HostTest.h"
+
+using namespace ArduinoJson;
+
+struct IgnoringHandler : JsonHandler {
+	void startObject() {}
+	void endObject() {}
+	void startArray() {}
+	void endArray() {}
+	void key(const char *) {}
+	void value(const JsonVariant &) {}
+};
+
+static bool streamParse(const char *json, uint8_t nesting_limit)
+{
+	IgnoringHandler handler;
+	JsonStreamParser<32> parser(handler, nesting_limit);
+	for (const char *c = json; *c != '\0'; c++) {
+		if (!parser.parse(*c))
+			return false;
+	}
+	return parser.finish();
+}
+
+static bool bufferParse(const char *json, uint8_t nesting_limit)
+{
+	DynamicJsonBuffer buffer;
+	if (json[0] == '[')
+		return buffer.parseArray(json, nesting_limit).success();
+	return buffer.parseObject(json, nesting_limit).success();
+}
+
+int main()
+{
+	static const char *documents[] = {
+		"[]", "[1]", "[[]]", "[[1]]", "[[[]]]", "[[\"a\"]]",
+		"{}", "{\"a\":1}", "{\"a\":{}}", "{\"a\":{\"b\":true}}", "{\"a\":[[]]}",
+	};
+	for (uint8_t limit = 0; limit < 4; limit++) {
+		for (size_t i = 0; i < sizeof(documents) / sizeof(documents[0]); i++) {
+			bool expected = bufferParse(documents[i], limit);
+			if (streamParse(documents[i], limit) != expected) {
+				printf("%s with limit %d: expected %d\n", documents[i], limit, expected);
+				test_failures++;
+			}
+		}
+	}
+	CHECK(!streamParse("[1]", 0));
+	CHECK(streamParse("[1]", 1));
+	return testResult("NestingTest");
+}
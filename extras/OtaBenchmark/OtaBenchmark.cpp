@@ -0,0 +1,544 @@
+/*	Copyright 2016 DeviceDrive AS
+*
+*	Licensed under the Apache License, Version 2.0 (the "License");
+*	you may not use this file except in compliance with the License.
+*	You may obtain a copy of the License at
+*
+*	http ://www.apache.org/licenses/LICENSE-2.0
+*
+*	Unless required by applicable law or agreed to in writing, software
+*	distributed under the License is distributed on an "AS IS" BASIS,
+*	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*	See the License for the specific language governing permissions and
+*	limitations under the License.
+*
+*/
+
+
+// Measures the transfer of a client image through the WRF class, against a
+// simulation of the WRF01 module, of the serial link and of the flash of the
+// Arduino Zero. The time is simulated, so the results don't depend on the
+// computer, except for the CPU time.
+// While the flash is erased or programmed, the CPU of the SAMD21 stops:
+// loopHandler() doesn't run, and the serial interrupt neither, so only the
+// bytes the SERCOM holds are kept. The others count as RX overflows.
+//
+// This is a tool for the computer, not for the Arduino. The chunk size is
+// fixed at build time, so the Makefile builds one program for each:
+//
+//	make run > results.csv
+//
+// Each line of the output is a scenario, in CSV:
+//	chunk_size         IMAGE_CHUNK_SIZE
+//	latency_ms         time the module takes to answer a command
+//	busy_rate          share of the chunk requests answered SYSTEM_BUSY first
+//	frame_check        CRC trailer on the frames (WRFConfig::frame_check)
+//	bytes_per_second   size of the image / simulated time of the transfer
+//	cpu_us_per_kb      CPU time spent in the library, per KB of image
+//	peak_heap_bytes    most memory allocated by the library with malloc()
+//	requests           chunks requested
+//	busy_answers       SYSTEM_BUSY answers
+//	rx_overflows       bytes lost because the RX buffer was full, or the
+//	                   CPU stopped for the flash
+//	flash_stall_ms     time the CPU stopped for the flash
+//	result             ok, or why the transfer failed
+//
+// With -r, the module restarts in the middle of the chunk of request
+// RESTART_REQUEST, as the WRF01 does: it sends STX ETX, then nothing until it
+// gets its setup again. The transfer must then resume from the saved state,
+// when the benchmark calls startClientUpgrade() again.
+
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <deque>
+#include <string>
+#include <vector>
+#include "WRF.h"
+
+#define BAUD_RATE 115200
+#define LOOP_PERIOD_US 1000			// loopHandler() is called every ms
+#define RX_BUFFER_SIZE 64			// RX buffer of the SAMD core
+#define SERCOM_FIFO_SIZE 2			// bytes the SERCOM holds without the CPU
+#define BUSY_DELAY_US 20000			// a busy module answers 20 ms later
+#define PAGE_WRITE_US 2500			// SAMD21 NVM timings
+#define ROW_ERASE_US 6000
+#define PAGE_SIZE 64
+#define ROW_SIZE 256
+#define STATE_SIZE (8 * ROW_SIZE)	// FLASH_STATE_SIZE of FlashImageStorage
+#define TRANSFER_TIMEOUT_US 600000000ull
+#define DEFAULT_IMAGE_SIZE (64 * 1024)
+#define RESTART_REQUEST 5
+
+static const int latencies_ms[] = { 0, 5, 20 };
+static const double busy_rates[] = { 0, 0.05, 0.2 };
+
+// Simulated time
+static uint64_t now_us = 0;
+
+unsigned long millis()
+{
+	return now_us / 1000;
+}
+
+unsigned long micros()
+{
+	return now_us;
+}
+
+void delay(unsigned long ms)
+{
+	now_us += ms * 1000;
+}
+
+// The allocations of the library are counted by wrapping malloc() at link
+// time (-Wl,--wrap=malloc,...). The standard library, which stands in for
+// Arduino's String, isn't wrapped.
+static size_t heap_bytes = 0;
+static size_t heap_peak = 0;
+
+extern "C" {
+void *__real_malloc(size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+static void countHeap(size_t freed, size_t allocated)
+{
+	heap_bytes = heap_bytes > freed ? heap_bytes - freed : 0;
+	heap_bytes += allocated;
+	if (heap_bytes > heap_peak)
+		heap_peak = heap_bytes;
+}
+
+void *__wrap_malloc(size_t size)
+{
+	void *ptr = __real_malloc(size);
+	if (ptr != NULL)
+		countHeap(0, malloc_usable_size(ptr));
+	return ptr;
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+	size_t old_size = ptr != NULL ? malloc_usable_size(ptr) : 0;
+	void *new_ptr = __real_realloc(ptr, size);
+	if (new_ptr != NULL)
+		countHeap(old_size, malloc_usable_size(new_ptr));
+	return new_ptr;
+}
+
+void __wrap_free(void *ptr)
+{
+	if (ptr != NULL)
+		countHeap(malloc_usable_size(ptr), 0);
+	__real_free(ptr);
+}
+}
+
+static uint64_t cpuTimeNs()
+{
+	struct timespec time;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time);
+	return (uint64_t)time.tv_sec * 1000000000ull + time.tv_nsec;
+}
+
+static uint32_t crcOf(const uint8_t *data, size_t size)
+{
+	Crc32 crc;
+	crc.update(data, size);
+	return crc.value();
+}
+
+static std::string crcTrailer(const std::string &payload)
+{
+	char trailer[FRAME_CRC_DIGITS + 1];
+	snprintf(trailer, sizeof(trailer), "%08X", (unsigned)crcOf((const uint8_t *)payload.data(), payload.size()));
+	return trailer;
+}
+
+// The WRF01 module behind the serial link. Both directions of the link carry
+// a byte every 10 bits, and the bytes that don't fit in the RX buffer of the
+// Arduino are lost.
+class ModuleSimulator : public HardwareSerial
+{
+	public:
+		ModuleSimulator(const std::string &image, int latency_ms, double busy_rate, bool restart)
+			: image(image), latency_us(latency_ms * 1000), busy_rate(busy_rate), restart(restart) {}
+
+		// Moves the bytes that reached the Arduino to its RX buffer
+		void advance()
+		{
+			receive(false);
+		}
+
+		// Stops the CPU until until_us, as the flash does
+		void stall(uint64_t until_us)
+		{
+			receive(false);
+			stall_us += until_us - now_us;
+			now_us = until_us;
+			receive(true);
+		}
+
+		virtual int available() { return rx_buffer.size(); }
+		virtual int peek() { return rx_buffer.empty() ? -1 : (uint8_t)rx_buffer.front(); }
+		virtual int read()
+		{
+			if (rx_buffer.empty())
+				return -1;
+			uint8_t data = rx_buffer.front();
+			rx_buffer.pop_front();
+			return data;
+		}
+
+		virtual size_t write(uint8_t data)
+		{
+			if (data != EOT_CHAR)
+				frame += (char)data;
+			else {
+				handleFrame(frame);
+				frame.clear();
+			}
+			// the frame reaches the module after its transmission
+			transmit_us += BYTE_US;
+			return 1;
+		}
+		using Print::write;
+
+		unsigned long requests = 0;
+		unsigned long busy_answers = 0;
+		unsigned long overflows = 0;
+		uint64_t stall_us = 0;
+
+	private:
+		static const uint64_t BYTE_US = 10 * 1000000ull / BAUD_RATE;
+
+		struct Segment {
+			uint64_t start_us;
+			std::string bytes;
+			size_t delivered;
+		};
+
+		const std::string &image;
+		uint64_t latency_us;
+		double busy_rate;
+		bool restart;
+		bool restarted = false;
+		uint32_t random_state = 0x2545F491;
+		bool frame_check = false;
+		std::string frame;
+		uint64_t transmit_us = 0;
+		uint64_t link_free_us = 0;
+		std::deque<Segment> segments;
+		std::deque<char> rx_buffer;
+
+		// Without the CPU, the bytes that arrive past the SERCOM are lost
+		void receive(bool stalled)
+		{
+			size_t held_bytes = 0;
+			while (!segments.empty() && segments.front().start_us <= now_us) {
+				Segment &segment = segments.front();
+				size_t arrived = (now_us - segment.start_us) / BYTE_US;
+				if (arrived > segment.bytes.size())
+					arrived = segment.bytes.size();
+				for (; segment.delivered < arrived; segment.delivered++) {
+					bool held = !stalled || held_bytes++ < SERCOM_FIFO_SIZE;
+					if (held && rx_buffer.size() < RX_BUFFER_SIZE)
+						rx_buffer.push_back(segment.bytes[segment.delivered]);
+					else
+						overflows++;
+				}
+				if (segment.delivered < segment.bytes.size())
+					break;
+				segments.pop_front();
+			}
+		}
+
+		void handleFrame(std::string request)
+		{
+			size_t trailer = request.rfind(US_CHAR);
+			if (trailer != std::string::npos)
+				request.erase(trailer);
+			uint64_t received_us = now_us + transmit_us;
+			transmit_us = 0;
+
+			bool setup = request.find("\"command\":\"setup\"") != std::string::npos;
+			if (setup)
+				frame_check = frame_check || request.find("\"frame_check\"") != std::string::npos;
+			// after a restart, only the setup is answered
+			if (restarted && !setup)
+				return;
+			restarted = false;
+
+			if (request.find("\"command\":\"get_upgrade\"") != std::string::npos) {
+				char announce[128];
+				snprintf(announce, sizeof(announce), "{\"devicedrive\":{\"image\":{\"size\":%u,\"crc\":\"%08X\"}}}",
+					(unsigned)image.size(), (unsigned)crcOf((const uint8_t *)image.data(), image.size()));
+				answer(received_us + latency_us, announce);
+			}
+			else if (request.find("\"command\":\"get_image\"") != std::string::npos) {
+				requests++;
+				size_t offset = number(request, "offset");
+				size_t length = number(request, "length");
+				uint64_t answer_us = received_us + latency_us;
+				if (nextRandom() < busy_rate) {
+					busy_answers++;
+					answer(answer_us, "{\"devicedrive\":{\"error\":\"SYSTEM_BUSY\"}}");
+					answer_us += BUSY_DELAY_US;
+				}
+				std::string chunk = image.substr(offset, length);
+				if (restart && requests == RESTART_REQUEST) {
+					restarted = true;
+					frame_check = false;
+					send(answer_us, SOH_CHAR + chunk.substr(0, length / 2) + STX_CHAR + ETX_CHAR);
+				}
+				else
+					send(answer_us, SOH_CHAR + chunk + crcTrailer(chunk));
+			}
+			else
+				answer(received_us + latency_us, "{\"devicedrive\":{\"result\":\"OK\"}}");
+		}
+
+		void answer(uint64_t at_us, const std::string &json)
+		{
+			if (frame_check)
+				send(at_us, json + US_CHAR + crcTrailer(json) + EOT_CHAR);
+			else
+				send(at_us, json + EOT_CHAR);
+		}
+
+		void send(uint64_t at_us, const std::string &bytes)
+		{
+			uint64_t start_us = at_us > link_free_us ? at_us : link_free_us;
+			link_free_us = start_us + bytes.size() * BYTE_US;
+			Segment segment = { start_us, bytes, 0 };
+			segments.push_back(segment);
+		}
+
+		static size_t number(const std::string &request, const char *key)
+		{
+			size_t position = request.find("\"" + std::string(key) + "\":\"");
+			return position == std::string::npos ? 0 : strtoul(request.c_str() + position + strlen(key) + 4, NULL, 10);
+		}
+
+		double nextRandom()
+		{
+			random_state ^= random_state << 13;
+			random_state ^= random_state >> 17;
+			random_state ^= random_state << 5;
+			return random_state / 4294967296.0;
+		}
+};
+
+// The internal flash, with the timings of the SAMD21: like FlashImageStorage,
+// a row is erased when it is reached, and a page is programmed when it is
+// full, each stopping the CPU until it is done.
+class SimulatedFlash : public ImageStorage
+{
+	public:
+		SimulatedFlash(ModuleSimulator &module) : module(module), state(STATE_SIZE, 0xff) {}
+
+		virtual bool begin(size_t size, bool resume)
+		{
+			if (!resume)
+				content.assign(size, 0xff);
+			position = 0;
+			row_erased = false;
+			page_length = 0;
+			return true;
+		}
+
+		virtual int write(size_t offset, const uint8_t *data, size_t size)
+		{
+			if (offset != position + page_length) {
+				position = offset;
+				row_erased = false;
+			}
+			if (position % ROW_SIZE == 0 && !row_erased) {
+				row_erased = true;
+				module.stall(now_us + ROW_ERASE_US);
+				return 0;
+			}
+			size_t count = PAGE_SIZE - page_length;
+			if (count > size)
+				count = size;
+			memcpy(&content[position + page_length], data, count);
+			page_length += count;
+			if (page_length == PAGE_SIZE)
+				writePage();
+			return count;
+		}
+
+		virtual bool end()
+		{
+			if (page_length > 0)
+				writePage();
+			return true;
+		}
+
+		virtual bool canReceiveWhileBusy()
+		{
+			return false;
+		}
+
+		// Like FlashImageStorage, the rows are erased when a bit goes from 0
+		// to 1, then the pages that changed are programmed
+		virtual bool saveState(const uint8_t *data, size_t size)
+		{
+			if (size > STATE_SIZE)
+				return false;
+			bool erase = false;
+			for (size_t i = 0; i < size && !erase; i++)
+				erase = (state[i] & data[i]) != data[i];
+			if (erase) {
+				state.assign(STATE_SIZE, 0xff);
+				module.stall(now_us + (size + ROW_SIZE - 1) / ROW_SIZE * ROW_ERASE_US);
+			}
+			for (size_t offset = 0; offset < size; offset += PAGE_SIZE) {
+				size_t length = size - offset < PAGE_SIZE ? size - offset : PAGE_SIZE;
+				if (memcmp(&state[offset], data + offset, length) == 0)
+					continue;
+				memcpy(&state[offset], data + offset, length);
+				module.stall(now_us + PAGE_WRITE_US);
+			}
+			return true;
+		}
+
+		virtual size_t loadState(uint8_t *data, size_t size)
+		{
+			if (size > STATE_SIZE)
+				return 0;
+			memcpy(data, state.data(), size);
+			return size;
+		}
+
+		std::vector<uint8_t> content;
+
+	private:
+		ModuleSimulator &module;
+		std::vector<uint8_t> state;
+		size_t position = 0;
+		bool row_erased = false;
+		size_t page_length = 0;
+
+		void writePage()
+		{
+			position += PAGE_SIZE;
+			page_length = 0;
+			row_erased = position % ROW_SIZE != 0;
+			module.stall(now_us + PAGE_WRITE_US);
+		}
+};
+
+static bool image_received = false;
+static bool image_interrupted = false;
+static String error_message;
+
+static void onImageReceived()
+{
+	image_received = true;
+}
+
+static void onError(String message)
+{
+	if (message == "Image transfer interrupted")
+		image_interrupted = true;
+	else if (error_message.length() == 0)
+		error_message = message;
+}
+
+static void runScenario(const std::string &image, int latency_ms, double busy_rate, bool frame_check, bool restart)
+{
+	now_us = 0;
+	image_received = false;
+	image_interrupted = false;
+	error_message = "";
+	ModuleSimulator module(image, latency_ms, busy_rate, restart);
+	SimulatedFlash flash(module);
+	uint64_t cpu_ns = 0;
+
+	WRF *wrf = new WRF(&module, "1.0", "benchmark", "[]");
+	wrf->onImageReceived(onImageReceived);
+	wrf->onError(onError);
+	wrf->setImageStorage(&flash);
+	WRFConfig config;
+	config.frame_check = frame_check;
+	wrf->setup(config);
+	while (!wrf->canSendCommand() || module.available() > 0 || now_us < 100000) {
+		now_us += LOOP_PERIOD_US;
+		module.advance();
+		wrf->loopHandler();
+	}
+
+	heap_peak = heap_bytes;
+	uint64_t start_us = now_us;
+	uint64_t cpu_start = cpuTimeNs();
+	wrf->startClientUpgrade(DEFAULT_FILE_NO, PROTOCOL_CHUNKED);
+	cpu_ns += cpuTimeNs() - cpu_start;
+	while (!image_received && error_message.length() == 0 && now_us - start_us < TRANSFER_TIMEOUT_US) {
+		now_us += LOOP_PERIOD_US;
+		module.advance();
+		cpu_start = cpuTimeNs();
+		wrf->loopHandler();
+		if (image_interrupted) {
+			image_interrupted = false;
+			wrf->startClientUpgrade(DEFAULT_FILE_NO, PROTOCOL_CHUNKED);
+		}
+		cpu_ns += cpuTimeNs() - cpu_start;
+	}
+	uint64_t elapsed_us = now_us - start_us;
+
+	const char *result = "ok";
+	if (error_message.length() > 0)
+		result = error_message.c_str();
+	else if (!image_received)
+		result = "timeout";
+	else if (flash.content.size() != image.size() || memcmp(flash.content.data(), image.data(), image.size()) != 0)
+		result = "corrupt";
+
+	printf("%d,%d,%.2f,%d,%u,%.0f,%.1f,%u,%lu,%lu,%lu,%.0f,%s\n",
+		IMAGE_CHUNK_SIZE, latency_ms, busy_rate, frame_check ? 1 : 0, (unsigned)image.size(),
+		image.size() * 1e6 / elapsed_us, cpu_ns / 1000.0 / (image.size() / 1024.0), (unsigned)heap_peak,
+		module.requests, module.busy_answers, module.overflows, module.stall_us / 1000.0, result);
+	delete wrf;
+}
+
+int main(int argc, char **argv)
+{
+	size_t image_size = DEFAULT_IMAGE_SIZE;
+	bool header = true;
+	bool restart = false;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-n") == 0)
+			header = false;
+		else if (strcmp(argv[i], "-r") == 0)
+			restart = true;
+		else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+			image_size = strtoul(argv[++i], NULL, 10);
+		else {
+			fprintf(stderr, "usage: %s [-n] [-r] [-s image_size]\n\t-n\tno CSV header\n"
+				"\t-r\trestart the module in the middle of a chunk\n", argv[0]);
+			return 1;
+		}
+	}
+
+	std::string image(image_size, '\0');
+	uint32_t seed = 1;
+	for (size_t i = 0; i < image_size; i++) {
+		seed = seed * 1103515245 + 12345;
+		image[i] = (char)(seed >> 16);
+	}
+
+	if (header)
+		printf("chunk_size,latency_ms,busy_rate,frame_check,image_bytes,bytes_per_second,cpu_us_per_kb,"
+			"peak_heap_bytes,requests,busy_answers,rx_overflows,flash_stall_ms,result\n");
+	for (size_t l = 0; l < sizeof(latencies_ms) / sizeof(latencies_ms[0]); l++) {
+		for (size_t b = 0; b < sizeof(busy_rates) / sizeof(busy_rates[0]); b++) {
+			for (int frame_check = 0; frame_check <= 1; frame_check++)
+				runScenario(image, latencies_ms[l], busy_rates[b], frame_check, restart);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,30 @@
+/*	Copyright 2016 DeviceDrive AS
+*
+*	Licensed under the Apache License, Version 2.0 (the "License");
+*	you may not use this file except in compliance with the License.
+*	You may obtain a copy of the License at
+*
+*	http ://www.apache.org/licenses/LICENSE-2.0
+*
+*	Unless required by applicable law or agreed to in writing, software
+*	distributed under the License is distributed on an "AS IS" BASIS,
+*	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*	See the License for the specific language governing permissions and
+*	limitations under the License.
+*
+*/
+#pragma once
+#include "Stream.h"
+
+class HardwareSerial : public Stream
+{
+	public:
+		virtual void begin(unsigned long baud) {}
+		virtual void end() {}
+		virtual int available() { return 0; }
+		virtual int read() { return -1; }
+		virtual int peek() { return -1; }
+		virtual size_t write(uint8_t data) { return 1; }
+		using Print::write;
+		operator bool() { return true; }
+};
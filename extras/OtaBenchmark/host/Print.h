@@ -0,0 +1,45 @@
+/*	Copyright 2016 DeviceDrive AS
+*
+*	Licensed under the Apache License, Version 2.0 (the "License");
+*	you may not use this file except in compliance with the License.
+*	You may obtain a copy of the License at
+*
+*	http ://www.apache.org/licenses/LICENSE-2.0
+*
+*	Unless required by applicable law or agreed to in writing, software
+*	distributed under the License is distributed on an "AS IS" BASIS,
+*	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*	See the License for the specific language governing permissions and
+*	limitations under the License.
+*
+*/
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+class String;
+
+class Print
+{
+	public:
+		virtual ~Print() {}
+		virtual size_t write(uint8_t data) = 0;
+		virtual size_t write(const uint8_t *buffer, size_t size)
+		{
+			size_t count = 0;
+			while (size-- && write(*buffer++))
+				count++;
+			return count;
+		}
+		size_t write(const char *str) { return str == NULL ? 0 : write((const uint8_t *)str, strlen(str)); }
+		size_t write(const char *buffer, size_t size) { return write((const uint8_t *)buffer, size); }
+
+		size_t print(const char str[]) { return write(str); }
+		size_t print(char c) { return write((uint8_t)c); }
+		size_t print(const String &str);
+		size_t print(int number);
+		size_t println() { return write("\r\n"); }
+		size_t println(const char str[]) { return print(str) + println(); }
+		size_t println(const String &str) { return print(str) + println(); }
+};
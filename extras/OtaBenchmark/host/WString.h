@@ -0,0 +1,102 @@
+/*	Copyright 2016 DeviceDrive AS
+*
+*	Licensed under the Apache License, Version 2.0 (the "License");
+*	you may not use this file except in compliance with the License.
+*	You may obtain a copy of the License at
+*
+*	http ://www.apache.org/licenses/LICENSE-2.0
+*
+*	Unless required by applicable law or agreed to in writing, software
+*	distributed under the License is distributed on an "AS IS" BASIS,
+*	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*	See the License for the specific language governing permissions and
+*	limitations under the License.
+*
+*/
+// Arduino's String on top of std::string
+
+#pragma once
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include "Print.h"
+
+class String
+{
+	public:
+		String() {}
+		String(const char *str) : text(str != NULL ? str : "") {}
+		String(const String &other) : text(other.text) {}
+		explicit String(char c) : text(1, c) {}
+		explicit String(int value) : text(std::to_string(value)) {}
+		explicit String(unsigned int value) : text(std::to_string(value)) {}
+		explicit String(long value) : text(std::to_string(value)) {}
+		explicit String(unsigned long value) : text(std::to_string(value)) {}
+		explicit String(float value, unsigned char decimals = 2) { setNumber(value, decimals); }
+		explicit String(double value, unsigned char decimals = 2) { setNumber(value, decimals); }
+
+		String &operator=(const String &other) { text = other.text; return *this; }
+		String &operator=(const char *str) { text = str != NULL ? str : ""; return *this; }
+
+		unsigned char reserve(unsigned int size) { text.reserve(size); return 1; }
+		unsigned int length() const { return text.size(); }
+		const char *c_str() const { return text.c_str(); }
+
+		unsigned char concat(const String &other) { text += other.text; return 1; }
+		unsigned char concat(const char *str) { if (str == NULL) return 0; text += str; return 1; }
+		unsigned char concat(char c) { text += c; return 1; }
+		unsigned char concat(int value) { text += std::to_string(value); return 1; }
+		unsigned char concat(unsigned long value) { text += std::to_string(value); return 1; }
+		String &operator+=(const String &other) { concat(other); return *this; }
+		String &operator+=(const char *str) { concat(str); return *this; }
+		String &operator+=(char c) { concat(c); return *this; }
+		friend String operator+(const String &a, const String &b) { String result(a); result += b; return result; }
+		friend String operator+(const String &a, const char *b) { String result(a); result += b; return result; }
+		friend String operator+(const char *a, const String &b) { String result(a); result += b; return result; }
+		friend String operator+(const String &a, char b) { String result(a); result += b; return result; }
+		friend String operator+(const String &a, int b) { String result(a); result.concat(b); return result; }
+
+		bool operator==(const String &other) const { return text == other.text; }
+		bool operator==(const char *str) const { return text == str; }
+		bool operator!=(const String &other) const { return text != other.text; }
+		bool operator!=(const char *str) const { return text != str; }
+		char operator[](unsigned int index) const { return text[index]; }
+		char &operator[](unsigned int index) { return text[index]; }
+		char charAt(unsigned int index) const { return text[index]; }
+
+		bool startsWith(const String &prefix) const { return text.compare(0, prefix.text.size(), prefix.text) == 0; }
+		bool endsWith(const String &suffix) const
+		{
+			return text.size() >= suffix.text.size()
+				&& text.compare(text.size() - suffix.text.size(), suffix.text.size(), suffix.text) == 0;
+		}
+		int indexOf(char c) const { return position(text.find(c)); }
+		int indexOf(const String &str) const { return position(text.find(str.text)); }
+		int lastIndexOf(char c) const { return position(text.rfind(c)); }
+		String substring(unsigned int begin) const { return String(text.substr(begin).c_str()); }
+		String substring(unsigned int begin, unsigned int end) const { return String(text.substr(begin, end - begin).c_str()); }
+		long toInt() const { return atol(text.c_str()); }
+
+		void toCharArray(char *buffer, unsigned int size, unsigned int index = 0) const
+		{
+			if (size == 0)
+				return;
+			size_t length = index < text.size() ? text.copy(buffer, size - 1, index) : 0;
+			buffer[length] = '\0';
+		}
+
+	private:
+		std::string text;
+
+		void setNumber(double value, unsigned char decimals)
+		{
+			char buffer[64];
+			snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+			text = buffer;
+		}
+
+		static int position(size_t index) { return index == std::string::npos ? -1 : (int)index; }
+};
+
+inline size_t Print::print(const String &str) { return write((const uint8_t *)str.c_str(), str.length()); }
+inline size_t Print::print(int number) { return print(String(number)); }
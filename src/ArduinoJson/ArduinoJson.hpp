@@ -9,10 +9,16 @@
 
 #include "ArduinoJson/DynamicJsonBuffer.hpp"
 #include "ArduinoJson/JsonArray.hpp"
+#include "ArduinoJson/JsonMinifier.hpp"
 #include "ArduinoJson/JsonObject.hpp"
+#include "ArduinoJson/JsonParseError.hpp"
+#include "ArduinoJson/JsonSchema.hpp"
+#include "ArduinoJson/JsonSpan.hpp"
+#include "ArduinoJson/JsonStreamParser.hpp"
 #include "ArduinoJson/StaticJsonBuffer.hpp"
 
 #include "ArduinoJson/Internals/JsonParser.ipp"
+#include "ArduinoJson/Internals/MsgPackParser.ipp"
 #include "ArduinoJson/JsonArray.ipp"
 #include "ArduinoJson/JsonBuffer.ipp"
 #include "ArduinoJson/JsonObject.ipp"
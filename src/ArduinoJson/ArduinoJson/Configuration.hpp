@@ -32,6 +32,17 @@
 #define ARDUINOJSON_ENABLE_STD_STREAM 0
 #endif
 
+// no vector unit on the microcontrollers we target
+#ifndef ARDUINOJSON_ENABLE_AVX2
+#define ARDUINOJSON_ENABLE_AVX2 0
+#endif
+#ifndef ARDUINOJSON_ENABLE_SSE2
+#define ARDUINOJSON_ENABLE_SSE2 0
+#endif
+#ifndef ARDUINOJSON_ENABLE_NEON
+#define ARDUINOJSON_ENABLE_NEON 0
+#endif
+
 #ifndef ARDUINOJSON_ENABLE_ALIGNMENT
 #ifdef ARDUINO_ARCH_AVR
 // alignment isn't needed for 8-bit AVR
@@ -77,6 +88,30 @@
 #define ARDUINOJSON_ENABLE_STD_STREAM 1
 #endif
 
+// scan strings 16 or 32 bytes at a time when the compiler targets SSE2, AVX2
+// or NEON
+#ifndef ARDUINOJSON_ENABLE_AVX2
+#if defined(__AVX2__) && defined(__GNUC__)
+#define ARDUINOJSON_ENABLE_AVX2 1
+#else
+#define ARDUINOJSON_ENABLE_AVX2 0
+#endif
+#endif
+#ifndef ARDUINOJSON_ENABLE_SSE2
+#if defined(__SSE2__) && defined(__GNUC__)
+#define ARDUINOJSON_ENABLE_SSE2 1
+#else
+#define ARDUINOJSON_ENABLE_SSE2 0
+#endif
+#endif
+#ifndef ARDUINOJSON_ENABLE_NEON
+#if defined(__aarch64__) && defined(__ARM_NEON) && defined(__GNUC__)
+#define ARDUINOJSON_ENABLE_NEON 1
+#else
+#define ARDUINOJSON_ENABLE_NEON 0
+#endif
+#endif
+
 #ifndef ARDUINOJSON_ENABLE_ALIGNMENT
 // even if not required, most cpu's are faster with aligned pointers
 #define ARDUINOJSON_ENABLE_ALIGNMENT 1
@@ -84,6 +119,29 @@
 
 #endif
 
+// convert numbers and booleans when parsing, instead of keeping the raw text
+// and converting it each time as<T>() or is<T>() is called.
+// Parsed floats are then written back in their shortest form, so "1.50"
+// becomes "1.5" when the document is serialized again, and as<const char*>()
+// returns NULL for numbers and booleans.
+#ifndef ARDUINOJSON_ENABLE_EAGER_PARSING
+#define ARDUINOJSON_ENABLE_EAGER_PARSING 0
+#endif
+
+// record what each JsonBuffer allocates, see JsonBuffer::stats()
+#ifndef ARDUINOJSON_ENABLE_MEMORY_STATS
+#define ARDUINOJSON_ENABLE_MEMORY_STATS 0
+#endif
+
+// JsonSchema needs variadic templates and constexpr
+#ifndef ARDUINOJSON_ENABLE_SCHEMA
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1900)
+#define ARDUINOJSON_ENABLE_SCHEMA 1
+#else
+#define ARDUINOJSON_ENABLE_SCHEMA 0
+#endif
+#endif
+
 #if ARDUINOJSON_USE_LONG_LONG && ARDUINOJSON_USE_INT64
 #error ARDUINOJSON_USE_LONG_LONG and ARDUINOJSON_USE_INT64 cannot be set together
 #endif
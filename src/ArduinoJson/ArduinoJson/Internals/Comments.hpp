@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include "StringScanner.hpp"
+
 namespace ArduinoJson {
 namespace Internals {
 inline const char *skipCStyleComment(const char *ptr) {
@@ -33,7 +35,8 @@ inline const char *skipSpacesAndComments(const char *ptr) {
       case '\t':
       case '\r':
       case '\n':
-        ptr++;
+        // the remainder of the run is skipped in bulk (indented documents)
+        ptr = StringScanner::skipSpaces(ptr + 1);
         continue;
       case '/':
         switch (ptr[1]) {
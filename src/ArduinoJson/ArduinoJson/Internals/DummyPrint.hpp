@@ -16,6 +16,8 @@ namespace Internals {
 class DummyPrint : public Print {
  public:
   virtual size_t write(uint8_t) { return 1; }
+
+  virtual size_t write(const uint8_t *, size_t size) { return size; }
 };
 }
 }
@@ -10,6 +10,8 @@
 #include "../Print.hpp"
 #include "../String.hpp"
 
+#include <string.h>  // for memcpy
+
 namespace ArduinoJson {
 namespace Internals {
 
@@ -24,9 +26,34 @@ class DynamicStringBuilder : public Print {
     return 1;
   }
 
+  virtual size_t write(const uint8_t *s, size_t n) {
+#if ARDUINOJSON_USE_ARDUINO_STRING
+    // Arduino's String only exposes concat() for null-terminated strings, so
+    // reserve once and append through a small stack buffer.
+    _str.reserve(_str.length() + n);
+    char chunk[CHUNK_SIZE + 1];
+    size_t remaining = n;
+    while (remaining > 0) {
+      size_t len = remaining < CHUNK_SIZE ? remaining : CHUNK_SIZE;
+      memcpy(chunk, s, len);
+      chunk[len] = '\0';
+      _str += chunk;
+      s += len;
+      remaining -= len;
+    }
+#else
+    _str.append(reinterpret_cast<const char *>(s), n);
+#endif
+    return n;
+  }
+
  private:
   DynamicStringBuilder &operator=(const DynamicStringBuilder &);
 
+#if ARDUINOJSON_USE_ARDUINO_STRING
+  static const size_t CHUNK_SIZE = 32;
+#endif
+
   String &_str;
 };
 }
@@ -7,35 +7,106 @@
 
 #pragma once
 
-#include "../Print.hpp"
+#include <stdint.h>
 
 namespace ArduinoJson {
 namespace Internals {
 
 class Encoding {
  public:
-  // Optimized for code size on a 8-bit AVR
+  // Returns the character to write after a backslash to escape c, or 0 if c
+  // can be written as is.
+  // Control characters without a short form return 'u', meaning they must be
+  // written as \u00XX.
   static char escapeChar(char c) {
-    const char *p = escapeTable(false);
-    while (p[0] && p[1] != c) {
-      p += 2;
-    }
-    return p[0];
+    return escapeTable()[static_cast<uint8_t>(c)];
   }
 
-  // Optimized for code size on a 8-bit AVR
+  // Returns the character represented by the escape sequence "\c".
   static char unescapeChar(char c) {
-    const char *p = escapeTable(true);
-    for (;;) {
-      if (p[0] == '\0') return c;
-      if (p[0] == c) return p[1];
-      p += 2;
-    }
+    char unescaped = unescapeTable()[static_cast<uint8_t>(c)];
+    return unescaped ? unescaped : c;
   }
 
  private:
-  static const char *escapeTable(bool excludeIdenticals) {
-    return &"\"\"\\\\b\bf\fn\nr\rt\t"[excludeIdenticals ? 4 : 0];
+  // One entry per byte value, so that the writer needs a single load per
+  // character instead of scanning a list of special characters.
+  static const char *escapeTable() {
+    static const char table[256] = {
+        'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u',
+        'b', 't', 'n', 'u', 'f', 'r', 'u', 'u',
+        'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u',
+        'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u',
+        0, 0, '"', 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, '\\', 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+    };
+    return table;
+  }
+
+  // One entry per byte value, 0 meaning that the character stands for itself
+  // (like \" or \\).
+  static const char *unescapeTable() {
+    static const char table[256] = {
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, '\b', 0, 0, 0, '\f', 0,
+        0, 0, 0, 0, 0, 0, '\n', 0,
+        0, 0, '\r', 0, '\t', 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+    };
+    return table;
   }
 };
 }
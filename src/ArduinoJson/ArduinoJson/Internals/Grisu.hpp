@@ -0,0 +1,357 @@
+// Copyright Benoit Blanchon 2014-2016
+// MIT License
+//
+// Arduino JSON library
+// https://github.com/bblanchon/ArduinoJson
+// If you like this project, please add a star!
+
+#pragma once
+
+#include "../Configuration.hpp"
+
+#include <stdint.h>
+#include <string.h>  // for memcpy
+
+namespace ArduinoJson {
+namespace Internals {
+
+// Layout of the IEEE-754 types
+template <typename TFloat>
+struct FloatTraits;
+
+template <>
+struct FloatTraits<double> {
+  typedef uint64_t bits_type;
+  static const int SIGNIFICAND_SIZE = 52;
+  static const int EXPONENT_BIAS = 0x3FF + SIGNIFICAND_SIZE;
+  static const int EXPONENT_MASK = 0x7FF;
+};
+
+template <>
+struct FloatTraits<float> {
+  typedef uint32_t bits_type;
+  static const int SIGNIFICAND_SIZE = 23;
+  static const int EXPONENT_BIAS = 0x7F + SIGNIFICAND_SIZE;
+  static const int EXPONENT_MASK = 0xFF;
+};
+
+// Generates the shortest string of decimal digits that reads back as the same
+// floating point value, using Florian Loitsch's Grisu2 algorithm ("Printing
+// Floating-Point Numbers Quickly and Accurately with Integers", PLDI 2010).
+//
+// Only integer arithmetic is used, which matters on microcontrollers without
+// an FPU. Grisu2 always round-trips; in rare cases (less than 0.1%) it emits
+// one digit more than strictly necessary.
+template <typename TFloat>
+class Grisu {
+ public:
+  // Maximum number of digits produced by generate()
+  static const int MAX_DIGITS =
+      FloatTraits<TFloat>::SIGNIFICAND_SIZE < 32 ? 9 : 17;
+
+  // Writes the digits of value in buffer, which must hold MAX_DIGITS chars.
+  // Returns the number of digits and sets exponent so that
+  // value == digits * 10^exponent.
+  // value must be finite and strictly positive.
+  static int generate(TFloat value, char *buffer, int *exponent) {
+    DiyFp v = DiyFp::fromFloat(value);
+    DiyFp minus, plus;
+    v.boundaries(&minus, &plus);
+
+    const DiyFp cachedPower = getCachedPower(plus.e, exponent);
+    const DiyFp w = v.normalize() * cachedPower;
+    DiyFp wPlus = plus * cachedPower;
+    DiyFp wMinus = minus * cachedPower;
+    // the products are off by one ulp at most, stay on the safe side
+    wMinus.f++;
+    wPlus.f--;
+
+    return generateDigits(w, wPlus, wPlus.f - wMinus.f, buffer, exponent);
+  }
+
+ private:
+  typedef FloatTraits<TFloat> traits;
+  typedef typename traits::bits_type bits_type;
+
+  // A "do-it-yourself floating point": f * 2^e
+  struct DiyFp {
+    uint64_t f;
+    int e;
+
+    DiyFp() : f(0), e(0) {}
+    DiyFp(uint64_t fp, int exp) : f(fp), e(exp) {}
+
+    static DiyFp fromFloat(TFloat value) {
+      const bits_type hiddenBit = bits_type(1) << traits::SIGNIFICAND_SIZE;
+      bits_type bits;
+      memcpy(&bits, &value, sizeof(bits));
+      int biasedExponent = static_cast<int>(bits >> traits::SIGNIFICAND_SIZE) &
+                           traits::EXPONENT_MASK;
+      bits_type significand = bits & (hiddenBit - 1);
+      if (biasedExponent != 0)
+        return DiyFp(significand + hiddenBit,
+                     biasedExponent - traits::EXPONENT_BIAS);
+      else  // subnormal
+        return DiyFp(significand, 1 - traits::EXPONENT_BIAS);
+    }
+
+    DiyFp operator-(const DiyFp &rhs) const {
+      return DiyFp(f - rhs.f, e);
+    }
+
+    // Multiplies the significands and keeps the upper 64 bits, rounded
+    DiyFp operator*(const DiyFp &rhs) const {
+      const uint64_t M32 = 0xFFFFFFFF;
+      const uint64_t a = f >> 32, b = f & M32;
+      const uint64_t c = rhs.f >> 32, d = rhs.f & M32;
+      const uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+      uint64_t tmp = (bd >> 32) + (ad & M32) + (bc & M32);
+      tmp += uint64_t(1) << 31;
+      return DiyFp(ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), e + rhs.e + 64);
+    }
+
+    // Shifts the significand so that its most significant bit is set
+    DiyFp normalize() const {
+      DiyFp r = *this;
+#ifdef __GNUC__
+      int shift = __builtin_clzll(r.f);
+      r.f <<= shift;
+      r.e -= shift;
+#else
+      while (!(r.f & (uint64_t(1) << 63))) {
+        r.f <<= 1;
+        r.e--;
+      }
+#endif
+      return r;
+    }
+
+    // Computes the normalized boundaries m- and m+ of the interval of values
+    // that round to this float.
+    void boundaries(DiyFp *minus, DiyFp *plus) const {
+      const uint64_t hiddenBit = uint64_t(1) << traits::SIGNIFICAND_SIZE;
+      DiyFp pl = DiyFp((f << 1) + 1, e - 1).normalize();
+      // the lower gap is twice smaller when f is a power of two
+      DiyFp mi = (f == hiddenBit) ? DiyFp((f << 2) - 1, e - 2)
+                                  : DiyFp((f << 1) - 1, e - 1);
+      mi.f <<= mi.e - pl.e;
+      mi.e = pl.e;
+      *plus = pl;
+      *minus = mi;
+    }
+  };
+
+  static DiyFp getCachedPower(int e, int *exponent) {
+    // k = ceil((-61 - e) * log10(2)) + 347
+    // 78913 / 2^18 approximates log10(2) closely enough for the range of e
+    int k = static_cast<int>(-((-(-61L - e) * 78913L) >> 18)) + 347;
+    int index = (k >> 3) + 1;
+    *exponent = 348 - index * 8;
+    return cachedPowers(index - FIRST_CACHED_POWER);
+  }
+
+  static uint64_t powerOf10(int n) {
+    static const uint64_t powers[] = {1ULL,
+                                      10ULL,
+                                      100ULL,
+                                      1000ULL,
+                                      10000ULL,
+                                      100000ULL,
+                                      1000000ULL,
+                                      10000000ULL,
+                                      100000000ULL,
+                                      1000000000ULL,
+                                      10000000000ULL,
+                                      100000000000ULL,
+                                      1000000000000ULL,
+                                      10000000000000ULL,
+                                      100000000000000ULL,
+                                      1000000000000000ULL,
+                                      10000000000000000ULL,
+                                      100000000000000000ULL,
+                                      1000000000000000000ULL,
+                                      10000000000000000000ULL};
+    return n < 20 ? powers[n] : 0;
+  }
+
+  static int countDecimalDigits(uint32_t n) {
+    int digits = 1;
+    while (digits < 10 && n >= powerOf10(digits)) digits++;
+    return digits;
+  }
+
+  static int generateDigits(const DiyFp &w, const DiyFp &wPlus, uint64_t delta,
+                            char *buffer, int *exponent) {
+    const DiyFp one(uint64_t(1) << -wPlus.e, wPlus.e);
+    const uint64_t distance = (wPlus - w).f;
+    uint32_t integral = static_cast<uint32_t>(wPlus.f >> -one.e);
+    uint64_t fractional = wPlus.f & (one.f - 1);
+    int kappa = countDecimalDigits(integral);
+    int length = 0;
+
+    // integral part
+    while (kappa > 0) {
+      uint32_t divisor = static_cast<uint32_t>(powerOf10(kappa - 1));
+      uint32_t digit = integral / divisor;
+      integral %= divisor;
+      if (digit || length) buffer[length++] = static_cast<char>('0' + digit);
+      kappa--;
+      uint64_t rest = (static_cast<uint64_t>(integral) << -one.e) + fractional;
+      if (rest <= delta) {
+        *exponent += kappa;
+        round(buffer, length, delta, rest, powerOf10(kappa) << -one.e,
+              distance);
+        return length;
+      }
+    }
+
+    // fractional part
+    for (;;) {
+      fractional *= 10;
+      delta *= 10;
+      char digit = static_cast<char>(fractional >> -one.e);
+      if (digit || length) buffer[length++] = static_cast<char>('0' + digit);
+      fractional &= one.f - 1;
+      kappa--;
+      if (fractional < delta) {
+        *exponent += kappa;
+        round(buffer, length, delta, fractional, one.f,
+              distance * powerOf10(-kappa));
+        return length;
+      }
+    }
+  }
+
+  // Moves the last digit closer to the exact value when possible
+  static void round(char *buffer, int length, uint64_t delta, uint64_t rest,
+                    uint64_t tenKappa, uint64_t distance) {
+    while (rest < distance && delta - rest >= tenKappa &&
+           (rest + tenKappa < distance ||
+            distance - rest > rest + tenKappa - distance)) {
+      buffer[length - 1]--;
+      rest += tenKappa;
+    }
+  }
+
+#if ARDUINOJSON_USE_DOUBLE
+  static const int FIRST_CACHED_POWER = 0;
+#else
+  // JsonFloat is a float: only the powers 1e-36 to 1e52 can be needed, which
+  // saves 1200 bytes of flash.
+  static const int FIRST_CACHED_POWER = 39;
+#endif
+
+  // Normalized approximations of 10^-348, 10^-340, ..., 10^340
+  static DiyFp cachedPowers(int index) {
+    static const struct {
+      uint64_t f;
+      int16_t e;
+    } powers[] = {
+#if ARDUINOJSON_USE_DOUBLE
+        {0xFA8FD5A0081C0288ULL, -1220},  // 1e-348
+        {0xBAAEE17FA23EBF76ULL, -1193},  // 1e-340
+        {0x8B16FB203055AC76ULL, -1166},  // 1e-332
+        {0xCF42894A5DCE35EAULL, -1140},  // 1e-324
+        {0x9A6BB0AA55653B2DULL, -1113},  // 1e-316
+        {0xE61ACF033D1A45DFULL, -1087},  // 1e-308
+        {0xAB70FE17C79AC6CAULL, -1060},  // 1e-300
+        {0xFF77B1FCBEBCDC4FULL, -1034},  // 1e-292
+        {0xBE5691EF416BD60CULL, -1007},  // 1e-284
+        {0x8DD01FAD907FFC3CULL, -980},  // 1e-276
+        {0xD3515C2831559A83ULL, -954},  // 1e-268
+        {0x9D71AC8FADA6C9B5ULL, -927},  // 1e-260
+        {0xEA9C227723EE8BCBULL, -901},  // 1e-252
+        {0xAECC49914078536DULL, -874},  // 1e-244
+        {0x823C12795DB6CE57ULL, -847},  // 1e-236
+        {0xC21094364DFB5637ULL, -821},  // 1e-228
+        {0x9096EA6F3848984FULL, -794},  // 1e-220
+        {0xD77485CB25823AC7ULL, -768},  // 1e-212
+        {0xA086CFCD97BF97F4ULL, -741},  // 1e-204
+        {0xEF340A98172AACE5ULL, -715},  // 1e-196
+        {0xB23867FB2A35B28EULL, -688},  // 1e-188
+        {0x84C8D4DFD2C63F3BULL, -661},  // 1e-180
+        {0xC5DD44271AD3CDBAULL, -635},  // 1e-172
+        {0x936B9FCEBB25C996ULL, -608},  // 1e-164
+        {0xDBAC6C247D62A584ULL, -582},  // 1e-156
+        {0xA3AB66580D5FDAF6ULL, -555},  // 1e-148
+        {0xF3E2F893DEC3F126ULL, -529},  // 1e-140
+        {0xB5B5ADA8AAFF80B8ULL, -502},  // 1e-132
+        {0x87625F056C7C4A8BULL, -475},  // 1e-124
+        {0xC9BCFF6034C13053ULL, -449},  // 1e-116
+        {0x964E858C91BA2655ULL, -422},  // 1e-108
+        {0xDFF9772470297EBDULL, -396},  // 1e-100
+        {0xA6DFBD9FB8E5B88FULL, -369},  // 1e-92
+        {0xF8A95FCF88747D94ULL, -343},  // 1e-84
+        {0xB94470938FA89BCFULL, -316},  // 1e-76
+        {0x8A08F0F8BF0F156BULL, -289},  // 1e-68
+        {0xCDB02555653131B6ULL, -263},  // 1e-60
+        {0x993FE2C6D07B7FACULL, -236},  // 1e-52
+        {0xE45C10C42A2B3B06ULL, -210},  // 1e-44
+        {0xAA242499697392D3ULL, -183},  // 1e-36
+        {0xFD87B5F28300CA0EULL, -157},  // 1e-28
+        {0xBCE5086492111AEBULL, -130},  // 1e-20
+        {0x8CBCCC096F5088CCULL, -103},  // 1e-12
+        {0xD1B71758E219652CULL, -77},  // 1e-4
+        {0x9C40000000000000ULL, -50},  // 1e4
+        {0xE8D4A51000000000ULL, -24},  // 1e12
+        {0xAD78EBC5AC620000ULL, 3},  // 1e20
+        {0x813F3978F8940984ULL, 30},  // 1e28
+        {0xC097CE7BC90715B3ULL, 56},  // 1e36
+        {0x8F7E32CE7BEA5C70ULL, 83},  // 1e44
+        {0xD5D238A4ABE98068ULL, 109},  // 1e52
+        {0x9F4F2726179A2245ULL, 136},  // 1e60
+        {0xED63A231D4C4FB27ULL, 162},  // 1e68
+        {0xB0DE65388CC8ADA8ULL, 189},  // 1e76
+        {0x83C7088E1AAB65DBULL, 216},  // 1e84
+        {0xC45D1DF942711D9AULL, 242},  // 1e92
+        {0x924D692CA61BE758ULL, 269},  // 1e100
+        {0xDA01EE641A708DEAULL, 295},  // 1e108
+        {0xA26DA3999AEF774AULL, 322},  // 1e116
+        {0xF209787BB47D6B85ULL, 348},  // 1e124
+        {0xB454E4A179DD1877ULL, 375},  // 1e132
+        {0x865B86925B9BC5C2ULL, 402},  // 1e140
+        {0xC83553C5C8965D3DULL, 428},  // 1e148
+        {0x952AB45CFA97A0B3ULL, 455},  // 1e156
+        {0xDE469FBD99A05FE3ULL, 481},  // 1e164
+        {0xA59BC234DB398C25ULL, 508},  // 1e172
+        {0xF6C69A72A3989F5CULL, 534},  // 1e180
+        {0xB7DCBF5354E9BECEULL, 561},  // 1e188
+        {0x88FCF317F22241E2ULL, 588},  // 1e196
+        {0xCC20CE9BD35C78A5ULL, 614},  // 1e204
+        {0x98165AF37B2153DFULL, 641},  // 1e212
+        {0xE2A0B5DC971F303AULL, 667},  // 1e220
+        {0xA8D9D1535CE3B396ULL, 694},  // 1e228
+        {0xFB9B7CD9A4A7443CULL, 720},  // 1e236
+        {0xBB764C4CA7A44410ULL, 747},  // 1e244
+        {0x8BAB8EEFB6409C1AULL, 774},  // 1e252
+        {0xD01FEF10A657842CULL, 800},  // 1e260
+        {0x9B10A4E5E9913129ULL, 827},  // 1e268
+        {0xE7109BFBA19C0C9DULL, 853},  // 1e276
+        {0xAC2820D9623BF429ULL, 880},  // 1e284
+        {0x80444B5E7AA7CF85ULL, 907},  // 1e292
+        {0xBF21E44003ACDD2DULL, 933},  // 1e300
+        {0x8E679C2F5E44FF8FULL, 960},  // 1e308
+        {0xD433179D9C8CB841ULL, 986},  // 1e316
+        {0x9E19DB92B4E31BA9ULL, 1013},  // 1e324
+        {0xEB96BF6EBADF77D9ULL, 1039},  // 1e332
+        {0xAF87023B9BF0EE6BULL, 1066},  // 1e340
+#else
+        {0xAA242499697392D3ULL, -183},  // 1e-36
+        {0xFD87B5F28300CA0EULL, -157},  // 1e-28
+        {0xBCE5086492111AEBULL, -130},  // 1e-20
+        {0x8CBCCC096F5088CCULL, -103},  // 1e-12
+        {0xD1B71758E219652CULL, -77},  // 1e-4
+        {0x9C40000000000000ULL, -50},  // 1e4
+        {0xE8D4A51000000000ULL, -24},  // 1e12
+        {0xAD78EBC5AC620000ULL, 3},  // 1e20
+        {0x813F3978F8940984ULL, 30},  // 1e28
+        {0xC097CE7BC90715B3ULL, 56},  // 1e36
+        {0x8F7E32CE7BEA5C70ULL, 83},  // 1e44
+        {0xD5D238A4ABE98068ULL, 109},  // 1e52
+#endif
+    };
+    return DiyFp(powers[index].f, powers[index].e);
+  }
+};
+}
+}
@@ -9,6 +9,8 @@
 
 #include "../Print.hpp"
 
+#include <string.h>  // for memchr
+
 namespace ArduinoJson {
 namespace Internals {
 
@@ -31,6 +33,21 @@ class IndentedPrint : public Print {
     return n;
   }
 
+  virtual size_t write(const uint8_t *s, size_t size) {
+    size_t n = 0;
+    while (size > 0) {
+      if (isNewLine) n += writeTabs();
+      // forward everything up to (and including) the next line break at once
+      const void *lf = memchr(s, '\n', size);
+      size_t len = lf ? static_cast<const uint8_t *>(lf) - s + 1 : size;
+      n += sink->write(s, len);
+      isNewLine = lf != NULL;
+      s += len;
+      size -= len;
+    }
+    return n;
+  }
+
   // Adds one level of indentation
   void indent() {
     if (level < MAX_LEVEL) level++;
@@ -0,0 +1,105 @@
+// Copyright Benoit Blanchon 2014-2016
+// MIT License
+//
+// Arduino JSON library
+// https://github.com/bblanchon/ArduinoJson
+// If you like this project, please add a star!
+
+#pragma once
+
+#include "JsonInteger.hpp"
+
+#include <stdint.h>
+
+namespace ArduinoJson {
+namespace Internals {
+
+// Converts unsigned integers to decimal text, two digits at a time.
+// The digits are written backwards, ending at the given position, so that the
+// caller doesn't need to know the length in advance.
+//
+// Most MCUs have no hardware divider, so the code avoids divisions:
+// - values below 10^4 are split with a multiplication instead of a division,
+// - values below 10^8 need a single 32-bit division,
+// - larger values are cut in blocks of 8 digits.
+class IntegerFormatter {
+ public:
+  // Size of a buffer that can hold any JsonUInt
+  static const int MAX_DIGITS = 20;
+
+  // Writes the digits of value and returns a pointer to the first one
+  static char *format(JsonUInt value, char *end) {
+    while (value >= 100000000UL) {
+      JsonUInt high = value / 100000000UL;
+      end = formatEightDigits(static_cast<uint32_t>(value - high * 100000000UL),
+                              end);
+      value = high;
+    }
+    return formatBelow10e8(static_cast<uint32_t>(value), end);
+  }
+
+ private:
+  // "00", "01", ... "99"
+  static const char *digitPairs() {
+    static const char pairs[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+    return pairs;
+  }
+
+  static char *writePair(uint32_t value, char *end) {
+    const char *pair = digitPairs() + 2 * value;
+    *--end = pair[1];
+    *--end = pair[0];
+    return end;
+  }
+
+  // x / 100 for any x < 43699, without a division
+  static uint32_t divideBy100(uint32_t value) {
+    return (value * 5243) >> 19;
+  }
+
+  // Writes exactly four digits, with leading zeros
+  static char *formatFourDigits(uint32_t value, char *end) {
+    uint32_t high = divideBy100(value);
+    end = writePair(value - high * 100, end);
+    return writePair(high, end);
+  }
+
+  // Writes exactly eight digits, with leading zeros
+  static char *formatEightDigits(uint32_t value, char *end) {
+    uint32_t high = value / 10000;
+    end = formatFourDigits(value - high * 10000, end);
+    return formatFourDigits(high, end);
+  }
+
+  // Writes a value < 10^4, without leading zeros
+  static char *formatBelow10e4(uint32_t value, char *end) {
+    if (value >= 100) {
+      uint32_t high = divideBy100(value);
+      end = writePair(value - high * 100, end);
+      value = high;
+    }
+    if (value >= 10) return writePair(value, end);
+    *--end = static_cast<char>('0' + value);
+    return end;
+  }
+
+  // Writes a value < 10^8, without leading zeros
+  static char *formatBelow10e8(uint32_t value, char *end) {
+    if (value < 10000) return formatBelow10e4(value, end);
+    uint32_t high = value / 10000;
+    end = formatFourDigits(value - high * 10000, end);
+    return formatBelow10e4(high, end);
+  }
+};
+}
+}
@@ -16,7 +16,7 @@ class JsonBufferAllocated {
  public:
   void *operator new(size_t n, JsonBuffer *jsonBuffer) throw() {
     if (!jsonBuffer) return NULL;
-    return jsonBuffer->alloc(n);
+    return jsonBuffer->allocNode(n);
   }
 
   void operator delete(void *, JsonBuffer *) throw() {}
@@ -0,0 +1,89 @@
+// Copyright Benoit Blanchon 2014-2016
+// MIT License
+//
+// Arduino JSON library
+// https://github.com/bblanchon/ArduinoJson
+// If you like this project, please add a star!
+
+#pragma once
+
+#include "../JsonField.hpp"
+#include "../JsonVariant.hpp"
+#include "JsonFieldTraits.hpp"
+#include "JsonWriter.hpp"
+
+#include <string.h>  // for strcmp
+
+namespace ArduinoJson {
+namespace Internals {
+
+// The fields of a JsonSchema, stored as a recursive list so that each one
+// keeps the type of its member.
+// This internal class is not indended to be used directly.
+// Instead, use JsonSchema.
+template <typename TStruct, typename... TMembers>
+class JsonFieldList;
+
+// The end of the list
+template <typename TStruct>
+class JsonFieldList<TStruct> {
+ public:
+  // Room for keys of up to 31 characters, even if the members don't need it
+  static const size_t TOKEN_CAPACITY = 32;
+
+  constexpr JsonFieldList() {}
+
+  void writeTo(const TStruct &, JsonWriter &) const {}
+
+  int indexOf(const char *, int) const {
+    return -1;
+  }
+
+  bool read(TStruct &, int, const JsonVariant &) const {
+    return false;
+  }
+};
+
+template <typename TStruct, typename TMember, typename... TRest>
+class JsonFieldList<TStruct, TMember, TRest...> {
+  typedef JsonFieldTraits<TMember> traits;
+  typedef JsonFieldList<TStruct, TRest...> rest_type;
+
+ public:
+  static const size_t TOKEN_CAPACITY =
+      traits::TOKEN_CAPACITY > rest_type::TOKEN_CAPACITY
+          ? traits::TOKEN_CAPACITY
+          : rest_type::TOKEN_CAPACITY;
+
+  constexpr JsonFieldList(JsonField<TStruct, TMember> first,
+                          JsonField<TStruct, TRest>... rest)
+      : _first(first), _rest(rest...) {}
+
+  // Writes the members, separated by commas, without the braces
+  void writeTo(const TStruct &object, JsonWriter &writer) const {
+    writer.writeString(_first.name);
+    writer.writeColon();
+    traits::write(writer, object.*_first.member);
+    if (sizeof...(TRest) > 0) writer.writeComma();
+    _rest.writeTo(object, writer);
+  }
+
+  // Returns the position of the field with this key, or -1
+  int indexOf(const char *key, int index = 0) const {
+    if (!strcmp(key, _first.name)) return index;
+    return _rest.indexOf(key, index + 1);
+  }
+
+  // Stores the value in the member at this position.
+  // Returns false if the value doesn't fit.
+  bool read(TStruct &object, int index, const JsonVariant &value) const {
+    if (index == 0) return traits::read(value, object.*_first.member);
+    return _rest.read(object, index - 1, value);
+  }
+
+ private:
+  JsonField<TStruct, TMember> _first;
+  rest_type _rest;
+};
+}
+}
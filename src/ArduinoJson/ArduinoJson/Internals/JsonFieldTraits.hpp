@@ -0,0 +1,174 @@
+// Copyright Benoit Blanchon 2014-2016
+// MIT License
+//
+// Arduino JSON library
+// https://github.com/bblanchon/ArduinoJson
+// If you like this project, please add a star!
+
+#pragma once
+
+#include "../JsonVariant.hpp"
+#include "../TypeTraits/EnableIf.hpp"
+#include "../TypeTraits/IsFloatingPoint.hpp"
+#include "../TypeTraits/IsSignedIntegral.hpp"
+#include "../TypeTraits/IsUnsignedIntegral.hpp"
+#include "JsonFloat.hpp"
+#include "JsonInteger.hpp"
+#include "JsonWriter.hpp"
+
+#include <string.h>  // for strlen, memcpy
+
+namespace ArduinoJson {
+namespace Internals {
+
+// Tells how a member of a struct is written to and read from JSON.
+// This internal class is not indended to be used directly.
+// Instead, use JsonSchema.
+//
+// Each specialization has:
+// - TOKEN_CAPACITY: the size of the longest token the member can accept,
+//   including the terminator
+// - write(): writes the value with a JsonWriter
+// - read(): converts the value given by the parser, returns false if it
+//   doesn't fit in the member
+//
+// The types that are not listed here are not supported, so a JsonSchema with
+// such a member fails to compile.
+template <typename T, typename Enable = void>
+struct JsonFieldTraits;
+
+template <>
+struct JsonFieldTraits<bool> {
+  static const size_t TOKEN_CAPACITY = 8;
+
+  static void write(JsonWriter &writer, bool value) {
+    writer.writeBoolean(value);
+  }
+
+  static bool read(const JsonVariant &value, bool &destination) {
+    if (!value.is<bool>()) return false;
+    destination = value.as<bool>();
+    return true;
+  }
+};
+
+// long long isn't in this list when JsonInteger can't hold it
+template <typename T>
+struct JsonFieldTraits<
+    T, typename TypeTraits::EnableIf<
+           TypeTraits::IsSignedIntegral<T>::value>::type> {
+  static const size_t TOKEN_CAPACITY = 32;
+
+  static void write(JsonWriter &writer, T value) {
+    if (value < 0) {
+      writer.writeRaw('-');
+      // the magnitude is computed on the unsigned type, so the most negative
+      // value doesn't overflow
+      writer.writeInteger(JsonUInt(0) - static_cast<JsonUInt>(value));
+    } else {
+      writer.writeInteger(static_cast<JsonUInt>(value));
+    }
+  }
+
+  static bool read(const JsonVariant &value, T &destination) {
+    if (!value.is<T>()) return false;
+    T result;
+    if (value.as<JsonFloat>() < 0) {
+      JsonInteger integer = value.as<JsonInteger>();
+      result = static_cast<T>(integer);
+      if (static_cast<JsonInteger>(result) != integer) return false;
+    } else {
+      JsonUInt integer = value.as<JsonUInt>();
+      result = static_cast<T>(integer);
+      if (result < 0 || static_cast<JsonUInt>(result) != integer) return false;
+    }
+    destination = result;
+    return true;
+  }
+};
+
+template <typename T>
+struct JsonFieldTraits<
+    T, typename TypeTraits::EnableIf<
+           TypeTraits::IsUnsignedIntegral<T>::value>::type> {
+  static const size_t TOKEN_CAPACITY = 32;
+
+  static void write(JsonWriter &writer, T value) {
+    writer.writeInteger(static_cast<JsonUInt>(value));
+  }
+
+  static bool read(const JsonVariant &value, T &destination) {
+    if (!value.is<T>() || value.as<JsonFloat>() < 0) return false;
+    JsonUInt integer = value.as<JsonUInt>();
+    T result = static_cast<T>(integer);
+    if (static_cast<JsonUInt>(result) != integer) return false;
+    destination = result;
+    return true;
+  }
+};
+
+// Floats are written with the fewest digits that read back as the same value.
+template <typename T>
+struct JsonFieldTraits<
+    T, typename TypeTraits::EnableIf<
+           TypeTraits::IsFloatingPoint<T>::value>::type> {
+  static const size_t TOKEN_CAPACITY = 32;
+
+  static void write(JsonWriter &writer, T value) {
+    writer.writeShortestFloat(narrow(value));
+  }
+
+  // A float is written as a float; wider types are read back as a JsonFloat
+  static float narrow(float value) {
+    return value;
+  }
+  static JsonFloat narrow(double value) {
+    return static_cast<JsonFloat>(value);
+  }
+  static JsonFloat narrow(long double value) {
+    return static_cast<JsonFloat>(value);
+  }
+
+  static bool read(const JsonVariant &value, T &destination) {
+    if (!value.is<T>() && !value.is<JsonInteger>()) return false;
+    destination = static_cast<T>(value.as<JsonFloat>());
+    return true;
+  }
+};
+
+// A string stored in the struct.
+// A string that doesn't fit is an error rather than being truncated, and null
+// gives an empty string.
+template <size_t N>
+struct JsonFieldTraits<char[N]> {
+  static const size_t TOKEN_CAPACITY = N;
+
+  static void write(JsonWriter &writer, const char *value) {
+    writer.writeString(value);
+  }
+
+  static bool read(const JsonVariant &value, char *destination) {
+    if (!value.is<const char *>()) return false;
+    const char *s = value.as<const char *>();
+    if (!s) s = "";
+    size_t length = strlen(s);
+    if (length >= N) return false;
+    memcpy(destination, s, length);
+    destination[length] = '\0';
+    return true;
+  }
+};
+
+// A pointer to a string that lives outside of the struct.
+// It can be written but not read, because the parser doesn't keep the
+// strings; use a char array for the members that must be read.
+template <>
+struct JsonFieldTraits<const char *> {
+  static const size_t TOKEN_CAPACITY = 0;
+
+  static void write(JsonWriter &writer, const char *value) {
+    writer.writeString(value);
+  }
+};
+}
+}
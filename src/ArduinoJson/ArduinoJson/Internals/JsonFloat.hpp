@@ -9,6 +9,8 @@
 
 #include "../Configuration.hpp"
 
+#include <stdint.h>
+
 namespace ArduinoJson {
 namespace Internals {
 
@@ -17,5 +19,15 @@ typedef double JsonFloat;
 #else
 typedef float JsonFloat;
 #endif
+
+// The number of decimals is kept in JsonVariantType, so it stays small
+// enough for the enum to hold it, even as a char with -fshort-enums.
+const uint8_t FLOAT_MAX_DECIMALS = 15;
+
+// Not a number of decimals: writes the shortest representation that reads
+// back as the same JsonFloat. Only JsonVariant(T, ShortestFloat) stores it,
+// so every number up to FLOAT_MAX_DECIMALS keeps its meaning.
+const uint8_t FLOAT_SHORTEST_DECIMALS = FLOAT_MAX_DECIMALS + 1;
+struct ShortestFloat {};
 }
 }
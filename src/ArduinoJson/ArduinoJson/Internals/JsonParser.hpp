@@ -8,6 +8,7 @@
 #pragma once
 
 #include "../JsonBuffer.hpp"
+#include "../JsonParseError.hpp"
 #include "../JsonVariant.hpp"
 
 namespace ArduinoJson {
@@ -22,6 +23,7 @@ class JsonParser {
       : _buffer(buffer),
         _readPtr(json ? json : ""),
         _writePtr(json),
+        _start(_readPtr),
         _nestingLimit(nestingLimit) {}
 
   JsonArray &parseArray();
@@ -33,9 +35,20 @@ class JsonParser {
     return result;
   }
 
+  // Why the last parse failed, if it did
+  const JsonParseError &error() const {
+    return _error;
+  }
+
  private:
   bool skip(char charToSkip);
 
+  // Keeps the first error: the others are the enclosing values failing
+  void fail(JsonParseError::Code code) {
+    if (_error.success())
+      _error = JsonParseError(code, static_cast<size_t>(_readPtr - _start));
+  }
+
   const char *parseString();
   bool parseAnythingTo(JsonVariant *destination);
   FORCE_INLINE bool parseAnythingToUnsafe(JsonVariant *destination);
@@ -60,7 +73,9 @@ class JsonParser {
   JsonBuffer *_buffer;
   const char *_readPtr;
   char *_writePtr;
+  const char *_start;
   uint8_t _nestingLimit;
+  JsonParseError _error;
 };
 }
 }
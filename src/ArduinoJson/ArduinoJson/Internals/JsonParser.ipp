@@ -9,6 +9,10 @@
 
 #include "Comments.hpp"
 #include "JsonParser.hpp"
+#include "ParseRawValue.hpp"
+#include "StringScanner.hpp"
+
+#include <string.h>  // for memmove
 
 inline bool ArduinoJson::Internals::JsonParser::skip(char charToSkip) {
   const char *ptr = skipSpacesAndComments(_readPtr);
@@ -20,7 +24,10 @@ inline bool ArduinoJson::Internals::JsonParser::skip(char charToSkip) {
 
 inline bool ArduinoJson::Internals::JsonParser::parseAnythingTo(
     JsonVariant *destination) {
-  if (_nestingLimit == 0) return false;
+  if (_nestingLimit == 0) {
+    fail(JsonParseError::TOO_DEEP);
+    return false;
+  }
   _nestingLimit--;
   bool success = parseAnythingToUnsafe(destination);
   _nestingLimit++;
@@ -47,6 +54,7 @@ inline ArduinoJson::JsonArray &
 ArduinoJson::Internals::JsonParser::parseArray() {
   // Create an empty array
   JsonArray &array = _buffer->createArray();
+  if (!array.success()) goto ERROR_NO_MEMORY;
 
   // Check opening braket
   if (!skip('[')) goto ERROR_MISSING_BRACKET;
@@ -68,10 +76,14 @@ SUCCESS_EMPTY_ARRAY:
 SUCCES_NON_EMPTY_ARRAY:
   return array;
 
+ERROR_NO_MEMORY:
+  fail(JsonParseError::NO_MEMORY);
+  return JsonArray::invalid();
+
 ERROR_INVALID_VALUE:
 ERROR_MISSING_BRACKET:
 ERROR_MISSING_COMMA:
-ERROR_NO_MEMORY:
+  fail(JsonParseError::INVALID_INPUT);
   return JsonArray::invalid();
 }
 
@@ -88,6 +100,7 @@ inline ArduinoJson::JsonObject &
 ArduinoJson::Internals::JsonParser::parseObject() {
   // Create an empty object
   JsonObject &object = _buffer->createObject();
+  if (!object.success()) goto ERROR_NO_MEMORY;
 
   // Check opening brace
   if (!skip('{')) goto ERROR_MISSING_BRACE;
@@ -114,12 +127,16 @@ SUCCESS_EMPTY_OBJECT:
 SUCCESS_NON_EMPTY_OBJECT:
   return object;
 
+ERROR_NO_MEMORY:
+  fail(JsonParseError::NO_MEMORY);
+  return JsonObject::invalid();
+
 ERROR_INVALID_KEY:
 ERROR_INVALID_VALUE:
 ERROR_MISSING_BRACE:
 ERROR_MISSING_COLON:
 ERROR_MISSING_COMMA:
-ERROR_NO_MEMORY:
+  fail(JsonParseError::INVALID_INPUT);
   return JsonObject::invalid();
 }
 
@@ -141,7 +158,14 @@ inline const char *ArduinoJson::Internals::JsonParser::parseString() {
   if (isQuote(c)) {  // quotes
     char stopChar = c;
     for (;;) {
-      c = *++readPtr;
+      // move the characters up to the next quote or backslash in one go
+      const char *runStart = readPtr + 1;
+      readPtr = StringScanner::findStringEnd(runStart, stopChar);
+      size_t runLength = static_cast<size_t>(readPtr - runStart);
+      memmove(writePtr, runStart, runLength);
+      writePtr += runLength;
+
+      c = *readPtr;
       if (c == '\0') break;
 
       if (c == stopChar) {
@@ -149,11 +173,9 @@ inline const char *ArduinoJson::Internals::JsonParser::parseString() {
         break;
       }
 
-      if (c == '\\') {
-        // replace char
-        c = Encoding::unescapeChar(*++readPtr);
-        if (c == '\0') break;
-      }
+      // replace char
+      c = Encoding::unescapeChar(*++readPtr);
+      if (c == '\0') break;
 
       *writePtr++ = c;
     }
@@ -184,8 +206,12 @@ inline bool ArduinoJson::Internals::JsonParser::parseStringTo(
   if (value == NULL) return false;
   if (hasQuotes) {
     *destination = value;
-  } else {
-    *destination = RawJson(value);
+    return true;
   }
+#if ARDUINOJSON_ENABLE_EAGER_PARSING
+  *destination = parseRawValue(value);
+  if (destination->success()) return true;
+#endif
+  *destination = RawJson(value);
   return true;
 }
@@ -11,7 +11,9 @@
 #include "DummyPrint.hpp"
 #include "IndentedPrint.hpp"
 #include "JsonWriter.hpp"
+#include "MsgPackWriter.hpp"
 #include "Prettyfier.hpp"
+#include "StaticByteBuilder.hpp"
 #include "StaticStringBuilder.hpp"
 #include "DynamicStringBuilder.hpp"
 
@@ -22,7 +24,7 @@
 namespace ArduinoJson {
 namespace Internals {
 
-// Implements all the overloads of printTo() and prettyPrintTo()
+// Implements all the overloads of printTo(), prettyPrintTo() and packTo()
 // Caution: this class use a template parameter to avoid virtual methods.
 // This is a bit curious but allows to reduce the size of JsonVariant, JsonArray
 // and JsonObject.
@@ -83,6 +85,23 @@ class JsonPrintable {
     return prettyPrintTo(dp);
   }
 
+  // Same as printTo() but with MessagePack instead of JSON text
+  size_t packTo(Print &print) const {
+    MsgPackWriter writer(print);
+    downcast().writeTo(writer);
+    return writer.bytesWritten();
+  }
+
+  size_t packTo(uint8_t *buffer, size_t bufferSize) const {
+    StaticByteBuilder sb(buffer, bufferSize);
+    return packTo(sb);
+  }
+
+  size_t measurePackedLength() const {
+    DummyPrint dp;
+    return packTo(dp);
+  }
+
  private:
   const T &downcast() const { return *static_cast<const T *>(this); }
 };
@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include "JsonFloat.hpp"
+
 namespace ArduinoJson {
 class JsonArray;
 class JsonObject;
@@ -30,10 +32,13 @@ enum JsonVariantType {
   // Multiple values are used for double, depending on the number of decimal
   // digits that must be printed in the JSON output.
   // This little trick allow to save one extra member in JsonVariant
-  JSON_FLOAT_0_DECIMALS
+  JSON_FLOAT_0_DECIMALS,
   // JSON_FLOAT_1_DECIMAL
   // JSON_FLOAT_2_DECIMALS
   // ...
+  // up to JSON_FLOAT_0_DECIMALS + FLOAT_MAX_DECIMALS, then the shortest form.
+  // Naming the last value makes it part of the range of the enum.
+  JSON_FLOAT_SHORTEST = JSON_FLOAT_0_DECIMALS + FLOAT_SHORTEST_DECIMALS
 };
 }
 }
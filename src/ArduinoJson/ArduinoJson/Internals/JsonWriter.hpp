@@ -12,8 +12,13 @@
 #include "../Polyfills/normalize.hpp"
 #include "../Print.hpp"
 #include "Encoding.hpp"
+#include "Grisu.hpp"
+#include "IntegerFormatter.hpp"
 #include "JsonFloat.hpp"
 #include "JsonInteger.hpp"
+#include "StringScanner.hpp"
+
+#include <string.h>  // for memcpy, memset
 
 namespace ArduinoJson {
 namespace Internals {
@@ -66,21 +71,41 @@ class JsonWriter {
       writeRaw("null");
     } else {
       writeRaw('\"');
-      while (*value) writeChar(*value++);
+      for (;;) {
+        // Characters that need no escaping are sent in runs rather than one
+        // by one.
+        const char *end = StringScanner::findEscapable(value);
+        writeRaw(value, static_cast<size_t>(end - value));
+        if (!*end) break;
+        writeEscaped(*end);
+        value = end + 1;
+      }
       writeRaw('\"');
     }
   }
 
   void writeChar(char c) {
-    char specialChar = Encoding::escapeChar(c);
-    if (specialChar) {
-      writeRaw('\\');
-      writeRaw(specialChar);
+    if (Encoding::escapeChar(c)) {
+      writeEscaped(c);
     } else {
       writeRaw(c);
     }
   }
 
+  void writeEscaped(char c) {
+    char specialChar = Encoding::escapeChar(c);
+    if (specialChar == 'u') {
+      // control character without a short form
+      static const char hexDigits[] = "0123456789abcdef";
+      char sequence[] = {'\\', 'u', '0', '0', hexDigits[(c >> 4) & 0xF],
+                         hexDigits[c & 0xF]};
+      writeRaw(sequence, sizeof(sequence));
+    } else {
+      char sequence[] = {'\\', specialChar};
+      writeRaw(sequence, sizeof(sequence));
+    }
+  }
+
   void writeFloat(JsonFloat value, uint8_t digits = 2) {
     if (Polyfills::isNaN(value)) return writeRaw("NaN");
 
@@ -91,6 +116,8 @@ class JsonWriter {
 
     if (Polyfills::isInfinity(value)) return writeRaw("Infinity");
 
+    if (digits == FLOAT_SHORTEST_DECIMALS) return writeShortestDigits(value);
+
     short powersOf10;
     if (value > 1000 || value < 0.001) {
       powersOf10 = Polyfills::normalize(value);
@@ -106,9 +133,14 @@ class JsonWriter {
     JsonFloat remainder = value - static_cast<JsonFloat>(int_part);
     writeInteger(int_part);
 
+    // The decimal point and the fractional digits are collected in a small
+    // buffer and sent in as few writes as possible
+    char buffer[16];
+    size_t length = 0;
+
     // Print the decimal point, but only if there are digits beyond
     if (digits > 0) {
-      writeRaw('.');
+      buffer[length++] = '.';
     }
 
     // Extract digits from the remainder one at a time
@@ -119,8 +151,13 @@ class JsonWriter {
       remainder -= static_cast<JsonFloat>(currentDigit);
 
       // Print
-      writeRaw(char('0' + currentDigit));
+      buffer[length++] = char('0' + currentDigit);
+      if (length == sizeof(buffer)) {
+        writeRaw(buffer, length);
+        length = 0;
+      }
     }
+    writeRaw(buffer, length);
 
     if (powersOf10 < 0) {
       writeRaw("e-");
@@ -133,22 +170,81 @@ class JsonWriter {
     }
   }
 
-  void writeInteger(JsonUInt value) {
-    char buffer[22];
-    char *ptr = buffer + sizeof(buffer) - 1;
+  // Writes value with the fewest digits that read back as the same T, so a
+  // float isn't written with the digits of its conversion to a double
+  template <typename T>
+  void writeShortestFloat(T value) {
+    if (Polyfills::isNaN(value)) return writeRaw("NaN");
+
+    if (value < 0) {
+      writeRaw('-');
+      value = -value;
+    }
 
-    *ptr = 0;
-    do {
-      *--ptr = static_cast<char>(value % 10 + '0');
-      value /= 10;
-    } while (value);
+    if (Polyfills::isInfinity(value)) return writeRaw("Infinity");
+
+    writeShortestDigits(value);
+  }
+
+  // Writes a positive value with the fewest digits that read back as the same
+  // T. Uses the same layout as JavaScript's Number.toString(), except that
+  // positive exponents have no '+' sign.
+  template <typename T>
+  void writeShortestDigits(T value) {
+    if (value == 0) return writeRaw('0');
 
-    writeRaw(ptr);
+    char digits[Grisu<T>::MAX_DIGITS];
+    int exponent;
+    int length = Grisu<T>::generate(value, digits, &exponent);
+
+    // position of the decimal point, relative to the first digit
+    int point = length + exponent;
+
+    char buffer[32];
+    char *ptr = buffer;
+    if (0 < point && point <= 21) {
+      if (length <= point) {  // 1234e5 -> 123400000
+        ptr = copyDigits(ptr, digits, length);
+        ptr = fillZeros(ptr, point - length);
+      } else {  // 1234e-2 -> 12.34
+        ptr = copyDigits(ptr, digits, point);
+        *ptr++ = '.';
+        ptr = copyDigits(ptr, digits + point, length - point);
+      }
+      writeRaw(buffer, static_cast<size_t>(ptr - buffer));
+    } else if (-6 < point && point <= 0) {  // 1234e-6 -> 0.001234
+      *ptr++ = '0';
+      *ptr++ = '.';
+      ptr = fillZeros(ptr, -point);
+      ptr = copyDigits(ptr, digits, length);
+      writeRaw(buffer, static_cast<size_t>(ptr - buffer));
+    } else {  // 1234e-10 -> 1.234e-7
+      *ptr++ = digits[0];
+      if (length > 1) {
+        *ptr++ = '.';
+        ptr = copyDigits(ptr, digits + 1, length - 1);
+      }
+      *ptr++ = 'e';
+      if (point < 1) *ptr++ = '-';
+      writeRaw(buffer, static_cast<size_t>(ptr - buffer));
+      writeInteger(static_cast<JsonUInt>(point < 1 ? 1 - point : point - 1));
+    }
+  }
+
+  void writeInteger(JsonUInt value) {
+    char buffer[IntegerFormatter::MAX_DIGITS];
+    char *end = buffer + sizeof(buffer);
+    char *ptr = IntegerFormatter::format(value, end);
+    writeRaw(ptr, static_cast<size_t>(end - ptr));
   }
 
   void writeRaw(const char *s) {
     _length += _sink.print(s);
   }
+  void writeRaw(const char *s, size_t n) {
+    if (n == 0) return;
+    _length += _sink.write(reinterpret_cast<const uint8_t *>(s), n);
+  }
   void writeRaw(char c) {
     _length += _sink.write(c);
   }
@@ -160,6 +256,16 @@ class JsonWriter {
  private:
   JsonWriter &operator=(const JsonWriter &);  // cannot be assigned
 
+  static char *copyDigits(char *dest, const char *digits, int n) {
+    memcpy(dest, digits, static_cast<size_t>(n));
+    return dest + n;
+  }
+
+  static char *fillZeros(char *dest, int n) {
+    memset(dest, '0', static_cast<size_t>(n));
+    return dest + n;
+  }
+
   static JsonFloat getLastDigit(uint8_t digits) {
     // Designed as a compromise between code size and speed
     switch (digits) {
@@ -0,0 +1,58 @@
+// Copyright Benoit Blanchon 2014-2016
+// MIT License
+//
+// Arduino JSON library
+// https://github.com/bblanchon/ArduinoJson
+// If you like this project, please add a star!
+
+#pragma once
+
+#include "../JsonBuffer.hpp"
+#include "../JsonVariant.hpp"
+
+namespace ArduinoJson {
+namespace Internals {
+
+// Parse MessagePack data to create JsonArrays and JsonObjects
+// This internal class is not indended to be used directly.
+// Instead, use JsonBuffer.parseMsgPack()
+class MsgPackParser {
+ public:
+  MsgPackParser(JsonBuffer *buffer, const uint8_t *data, size_t size,
+                uint8_t nestingLimit)
+      : _buffer(buffer),
+        _readPtr(data),
+        _endPtr(data ? data + size : data),
+        _nestingLimit(nestingLimit) {}
+
+  JsonVariant parseVariant() {
+    JsonVariant result;
+    if (!parseAnythingTo(&result)) return JsonVariant();
+    return result;
+  }
+
+ private:
+  bool parseAnythingTo(JsonVariant *destination);
+  bool parseAnythingToUnsafe(JsonVariant *destination);
+
+  inline bool parseArrayTo(JsonVariant *destination, size_t size);
+  inline bool parseObjectTo(JsonVariant *destination, size_t size);
+  inline bool parseIntegerTo(JsonVariant *destination, uint8_t size,
+                             bool isSigned);
+  inline bool parseFloatTo(JsonVariant *destination, uint8_t size);
+
+  // Reads a string whose first byte is code.
+  // Returns NULL if code isn't a string.
+  inline const char *parseString(uint8_t code);
+  inline const char *readString(size_t length);
+
+  // Reads a big-endian unsigned integer of size bytes
+  inline bool readInteger(uint8_t size, uint64_t *value);
+
+  JsonBuffer *_buffer;
+  const uint8_t *_readPtr;
+  const uint8_t *_endPtr;
+  uint8_t _nestingLimit;
+};
+}
+}
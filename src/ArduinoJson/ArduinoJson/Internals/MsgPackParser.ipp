@@ -0,0 +1,238 @@
+// Copyright Benoit Blanchon 2014-2016
+// MIT License
+//
+// Arduino JSON library
+// https://github.com/bblanchon/ArduinoJson
+// If you like this project, please add a star!
+
+#pragma once
+
+#include "../JsonArray.hpp"
+#include "../JsonObject.hpp"
+#include "../RawJson.hpp"
+#include "JsonFloat.hpp"
+#include "MsgPackParser.hpp"
+
+#include <string.h>  // for memcpy
+
+inline bool ArduinoJson::Internals::MsgPackParser::parseAnythingTo(
+    JsonVariant *destination) {
+  if (_nestingLimit == 0) return false;
+  _nestingLimit--;
+  bool success = parseAnythingToUnsafe(destination);
+  _nestingLimit++;
+  return success;
+}
+
+inline bool ArduinoJson::Internals::MsgPackParser::parseAnythingToUnsafe(
+    JsonVariant *destination) {
+  if (_readPtr >= _endPtr) return false;
+  uint8_t code = *_readPtr++;
+
+  // positive fixint
+  if (code <= 0x7f) {
+    *destination = static_cast<JsonUInt>(code);
+    return true;
+  }
+
+  // negative fixint
+  if (code >= 0xe0) {
+    *destination = -static_cast<JsonInteger>(0x100 - code);
+    return true;
+  }
+
+  // fixmap, fixarray and fixstr
+  if (code <= 0x8f) return parseObjectTo(destination, code & 0x0f);
+  if (code <= 0x9f) return parseArrayTo(destination, code & 0x0f);
+  if (code <= 0xbf) {
+    const char *value = parseString(code);
+    if (!value) return false;
+    *destination = value;
+    return true;
+  }
+
+  uint64_t size;
+  switch (code) {
+    case 0xc0:
+      *destination = RawJson("null");
+      return true;
+
+    case 0xc2:
+    case 0xc3:
+      *destination = code == 0xc3;
+      return true;
+
+    case 0xca:
+      return parseFloatTo(destination, 4);
+    case 0xcb:
+      return parseFloatTo(destination, 8);
+
+    case 0xcc:
+      return parseIntegerTo(destination, 1, false);
+    case 0xcd:
+      return parseIntegerTo(destination, 2, false);
+    case 0xce:
+      return parseIntegerTo(destination, 4, false);
+    case 0xcf:
+      return parseIntegerTo(destination, 8, false);
+    case 0xd0:
+      return parseIntegerTo(destination, 1, true);
+    case 0xd1:
+      return parseIntegerTo(destination, 2, true);
+    case 0xd2:
+      return parseIntegerTo(destination, 4, true);
+    case 0xd3:
+      return parseIntegerTo(destination, 8, true);
+
+    case 0xd9:
+    case 0xda:
+    case 0xdb: {
+      const char *value = parseString(code);
+      if (!value) return false;
+      *destination = value;
+      return true;
+    }
+
+    case 0xdc:
+    case 0xdd:
+      if (!readInteger(code == 0xdc ? 2 : 4, &size)) return false;
+      return parseArrayTo(destination, static_cast<size_t>(size));
+
+    case 0xde:
+    case 0xdf:
+      if (!readInteger(code == 0xde ? 2 : 4, &size)) return false;
+      return parseObjectTo(destination, static_cast<size_t>(size));
+
+    default:
+      // binary and extension types have no equivalent in JSON
+      return false;
+  }
+}
+
+inline bool ArduinoJson::Internals::MsgPackParser::parseArrayTo(
+    JsonVariant *destination, size_t size) {
+  JsonArray &array = _buffer->createArray();
+  if (!array.success()) return false;
+
+  for (; size > 0; size--) {
+    JsonVariant value;
+    if (!parseAnythingTo(&value)) return false;
+    if (!array.add(value)) return false;
+  }
+
+  *destination = array;
+  return true;
+}
+
+inline bool ArduinoJson::Internals::MsgPackParser::parseObjectTo(
+    JsonVariant *destination, size_t size) {
+  JsonObject &object = _buffer->createObject();
+  if (!object.success()) return false;
+
+  for (; size > 0; size--) {
+    // only string keys can be represented in JSON
+    if (_readPtr >= _endPtr) return false;
+    const char *key = parseString(*_readPtr++);
+    if (!key) return false;
+
+    JsonVariant value;
+    if (!parseAnythingTo(&value)) return false;
+    if (!object.set(key, value)) return false;
+  }
+
+  *destination = object;
+  return true;
+}
+
+inline bool ArduinoJson::Internals::MsgPackParser::parseIntegerTo(
+    JsonVariant *destination, uint8_t size, bool isSigned) {
+  uint64_t value;
+  if (!readInteger(size, &value)) return false;
+
+  const JsonUInt maxValue = ~JsonUInt(0);
+  const JsonUInt maxMagnitude = maxValue >> 1;
+  uint64_t signBit = uint64_t(1) << (8 * size - 1);
+
+  if (isSigned && (value & signBit)) {
+    // two's complement on size bytes
+    uint64_t magnitude = ((~value) & (signBit | (signBit - 1))) + 1;
+    if (magnitude <= maxMagnitude)
+      *destination = -static_cast<JsonInteger>(magnitude);
+    else  // doesn't fit in a JsonInteger
+      *destination =
+          JsonVariant(-static_cast<JsonFloat>(magnitude), ShortestFloat());
+    return true;
+  }
+
+  if (value <= maxValue)
+    *destination = static_cast<JsonUInt>(value);
+  else  // doesn't fit in a JsonUInt
+    *destination =
+        JsonVariant(static_cast<JsonFloat>(value), ShortestFloat());
+  return true;
+}
+
+inline bool ArduinoJson::Internals::MsgPackParser::parseFloatTo(
+    JsonVariant *destination, uint8_t size) {
+  uint64_t bits;
+  if (!readInteger(size, &bits)) return false;
+
+  JsonFloat value;
+  if (size == 4) {
+    float single;
+    uint32_t bits32 = static_cast<uint32_t>(bits);
+    memcpy(&single, &bits32, sizeof(single));
+    value = static_cast<JsonFloat>(single);
+  } else {
+    double full;
+    memcpy(&full, &bits, sizeof(full));
+    value = static_cast<JsonFloat>(full);
+  }
+
+  *destination = JsonVariant(value, ShortestFloat());
+  return true;
+}
+
+inline const char *ArduinoJson::Internals::MsgPackParser::parseString(
+    uint8_t code) {
+  if (0xa0 <= code && code <= 0xbf) return readString(code & 0x1f);
+
+  uint64_t length;
+  switch (code) {
+    case 0xd9:
+      if (!readInteger(1, &length)) return NULL;
+      break;
+    case 0xda:
+      if (!readInteger(2, &length)) return NULL;
+      break;
+    case 0xdb:
+      if (!readInteger(4, &length)) return NULL;
+      break;
+    default:
+      return NULL;
+  }
+  return readString(static_cast<size_t>(length));
+}
+
+inline const char *ArduinoJson::Internals::MsgPackParser::readString(
+    size_t length) {
+  if (static_cast<size_t>(_endPtr - _readPtr) < length) return NULL;
+
+  // unlike the JSON parser, the string can't be terminated in place
+  char *value = _buffer->allocString(length + 1);
+  if (!value) return NULL;
+  memcpy(value, _readPtr, length);
+  value[length] = '\0';
+
+  _readPtr += length;
+  return value;
+}
+
+inline bool ArduinoJson::Internals::MsgPackParser::readInteger(
+    uint8_t size, uint64_t *value) {
+  if (static_cast<size_t>(_endPtr - _readPtr) < size) return false;
+
+  *value = 0;
+  while (size--) *value = (*value << 8) | *_readPtr++;
+  return true;
+}
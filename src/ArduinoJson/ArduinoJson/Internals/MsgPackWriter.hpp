@@ -0,0 +1,175 @@
+// Copyright Benoit Blanchon 2014-2016
+// MIT License
+//
+// Arduino JSON library
+// https://github.com/bblanchon/ArduinoJson
+// If you like this project, please add a star!
+
+#pragma once
+
+#include "../Print.hpp"
+#include "JsonFloat.hpp"
+#include "JsonInteger.hpp"
+
+#include <stdint.h>
+#include <string.h>  // for strlen, memcpy
+
+namespace ArduinoJson {
+namespace Internals {
+
+// Writes the values of a JsonArray, a JsonObject or a JsonVariant in the
+// MessagePack format (http://msgpack.org) to a Print implementation.
+// This class is used by:
+// - JsonArray::writeTo()
+// - JsonObject::writeTo()
+// - JsonVariant::writeTo()
+// Each value uses the smallest encoding that holds it.
+class MsgPackWriter {
+ public:
+  explicit MsgPackWriter(Print &sink) : _sink(sink), _length(0) {}
+
+  // Returns the number of bytes sent to the Print implementation.
+  size_t bytesWritten() const {
+    return _length;
+  }
+
+  void beginArray(size_t size) {
+    writeHeader(size, 0x90, 15, 0xdc);
+  }
+
+  void beginObject(size_t size) {
+    writeHeader(size, 0x80, 15, 0xde);
+  }
+
+  void writeString(const char *value) {
+    if (!value) return writeNull();
+    size_t length = strlen(value);
+    if (length < 32) {
+      writeByte(static_cast<uint8_t>(0xa0 | length));
+    } else if (length <= 0xFF) {
+      writeByte(0xd9);
+      writeByte(static_cast<uint8_t>(length));
+    } else {
+      writeHeader(length, 0, 0, 0xda);
+    }
+    writeRaw(reinterpret_cast<const uint8_t *>(value), length);
+  }
+
+  void writeInteger(JsonUInt value, bool negative) {
+    if (!negative) return writePositiveInteger(value);
+
+    // two's complement of the magnitude, computed on the unsigned type
+    JsonUInt bits = ~value + 1;
+    if (value <= 32) {
+      writeByte(static_cast<uint8_t>(bits));
+    } else if (value <= 0x80) {
+      writeByte(0xd0);
+      writeByte(static_cast<uint8_t>(bits));
+    } else if (value <= 0x8000) {
+      writeByte(0xd1);
+      writeBigEndian(static_cast<uint16_t>(bits));
+    } else if (value <= 0x80000000UL) {
+      writeByte(0xd2);
+      writeBigEndian(static_cast<uint32_t>(bits));
+    } else {
+      writeByte(0xd3);
+      writeBigEndian64(bits);
+    }
+  }
+
+  // Floats that don't lose anything as a 32-bit float are written as such
+  void writeFloat(JsonFloat value) {
+    float single = static_cast<float>(value);
+    if (static_cast<JsonFloat>(single) == value || value != value) {
+      uint32_t bits;
+      memcpy(&bits, &single, sizeof(bits));
+      writeByte(0xca);
+      writeBigEndian(bits);
+    } else {
+      uint64_t bits;
+      double full = static_cast<double>(value);
+      memcpy(&bits, &full, sizeof(bits));
+      writeByte(0xcb);
+      writeBigEndian(static_cast<uint32_t>(bits >> 32));
+      writeBigEndian(static_cast<uint32_t>(bits));
+    }
+  }
+
+  void writeBoolean(bool value) {
+    writeByte(value ? 0xc3 : 0xc2);
+  }
+
+  void writeNull() {
+    writeByte(0xc0);
+  }
+
+ private:
+  void writePositiveInteger(JsonUInt value) {
+    if (value < 0x80) {
+      writeByte(static_cast<uint8_t>(value));
+    } else if (value <= 0xFF) {
+      writeByte(0xcc);
+      writeByte(static_cast<uint8_t>(value));
+    } else if (value <= 0xFFFF) {
+      writeByte(0xcd);
+      writeBigEndian(static_cast<uint16_t>(value));
+    } else if (value <= 0xFFFFFFFFUL) {
+      writeByte(0xce);
+      writeBigEndian(static_cast<uint32_t>(value));
+    } else {
+      writeByte(0xcf);
+      writeBigEndian64(value);
+    }
+  }
+
+  // Writes the header of an array, a map or a string.
+  // fixCode is used for the sizes up to fixMax, code16 for 16-bit sizes and
+  // code16 + 1 for 32-bit sizes.
+  void writeHeader(size_t size, uint8_t fixCode, size_t fixMax,
+                   uint8_t code16) {
+    if (size <= fixMax) {
+      writeByte(static_cast<uint8_t>(fixCode | size));
+    } else if (size <= 0xFFFF) {
+      writeByte(code16);
+      writeBigEndian(static_cast<uint16_t>(size));
+    } else {
+      writeByte(static_cast<uint8_t>(code16 + 1));
+      writeBigEndian(static_cast<uint32_t>(size));
+    }
+  }
+
+  void writeBigEndian(uint16_t value) {
+    uint8_t bytes[] = {static_cast<uint8_t>(value >> 8),
+                       static_cast<uint8_t>(value)};
+    writeRaw(bytes, sizeof(bytes));
+  }
+
+  void writeBigEndian(uint32_t value) {
+    uint8_t bytes[] = {
+        static_cast<uint8_t>(value >> 24), static_cast<uint8_t>(value >> 16),
+        static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value)};
+    writeRaw(bytes, sizeof(bytes));
+  }
+
+  // JsonUInt is 32-bit on some platforms, so the shift is done in two steps
+  void writeBigEndian64(JsonUInt value) {
+    writeBigEndian(static_cast<uint32_t>((value >> 16) >> 16));
+    writeBigEndian(static_cast<uint32_t>(value));
+  }
+
+  void writeByte(uint8_t c) {
+    _length += _sink.write(c);
+  }
+
+  void writeRaw(const uint8_t *s, size_t n) {
+    if (n == 0) return;
+    _length += _sink.write(s, n);
+  }
+
+  Print &_sink;
+  size_t _length;
+
+  MsgPackWriter &operator=(const MsgPackWriter &);  // cannot be assigned
+};
+}
+}
@@ -0,0 +1,74 @@
+// Copyright Benoit Blanchon 2014-2016
+// MIT License
+//
+// Arduino JSON library
+// https://github.com/bblanchon/ArduinoJson
+// If you like this project, please add a star!
+
+#pragma once
+
+#include "../JsonVariant.hpp"
+#include "JsonFloat.hpp"
+#include "JsonInteger.hpp"
+#include "Parse.hpp"
+
+#include <string.h>  // for strcmp
+
+namespace ArduinoJson {
+namespace Internals {
+
+inline bool isDigit(char c) {
+  return '0' <= c && c <= '9';
+}
+
+// Skips a sequence of at least one digit.
+// Returns NULL if there is no digit.
+inline const char *skipDigits(const char *s) {
+  if (!isDigit(*s)) return NULL;
+  while (isDigit(*s)) s++;
+  return s;
+}
+
+// Converts the text of an unquoted token to a boolean, an integer or a float.
+// Returns an undefined JsonVariant if the text is none of these, so the caller
+// can keep it as a RawJson.
+// Integers too large for a JsonInteger/JsonUInt become floats, like they would
+// with JsonVariant::is<long>() and is<double>() on the raw text.
+inline JsonVariant parseRawValue(const char *s) {
+  if (!strcmp(s, "true")) return true;
+  if (!strcmp(s, "false")) return false;
+
+  const char *p = s;
+  bool negative = *p == '-';
+  if (negative) p++;
+  if (!isDigit(*p)) return JsonVariant();
+
+  // accumulate the integer part, watching for overflows
+  const JsonUInt maxValue =
+      negative ? static_cast<JsonUInt>(~JsonUInt(0) >> 1) : ~JsonUInt(0);
+  JsonUInt value = 0;
+  bool overflow = false;
+  for (; isDigit(*p); p++) {
+    JsonUInt digit = static_cast<JsonUInt>(*p - '0');
+    if (value > (maxValue - digit) / 10) overflow = true;
+    value = value * 10 + digit;
+  }
+
+  if (*p == '\0' && !overflow) {
+    if (negative) return -static_cast<JsonInteger>(value);
+    return value;
+  }
+
+  // check the rest follows the syntax of a JSON number
+  if (*p == '.') p = skipDigits(p + 1);
+  if (p && (*p == 'e' || *p == 'E')) {
+    p++;
+    if (*p == '+' || *p == '-') p++;
+    p = skipDigits(p);
+  }
+  if (!p || *p != '\0') return JsonVariant();
+
+  return JsonVariant(parse<JsonFloat>(s), ShortestFloat());
+}
+}
+}
@@ -0,0 +1,208 @@
+// Copyright Benoit Blanchon 2014-2016
+// MIT License
+//
+// Arduino JSON library
+// https://github.com/bblanchon/ArduinoJson
+// If you like this project, please add a star!
+
+#pragma once
+
+#include "Comments.hpp"
+#include "Encoding.hpp"
+#include "StringScanner.hpp"
+
+#include <stddef.h>  // for size_t, NULL
+
+namespace ArduinoJson {
+namespace Internals {
+
+// Walks through JSON text without parsing it.
+// Arrays and objects are skipped by bracket matching, so their content is
+// not checked. Every function takes a pointer to the first character of a
+// token in a null-terminated text and returns NULL if the text ends before
+// the token does.
+// This class is used by JsonSpan.
+class RawJsonScanner {
+ public:
+  // Returns the first character after the value that starts at s
+  static const char *skipValue(const char *s) {
+    switch (*s) {
+      case '{':
+      case '[':
+        return skipContainer(s);
+      case '\"':
+      case '\'':
+        return skipString(s);
+      default:
+        return skipBareToken(s);
+    }
+  }
+
+  // Returns the value of the member with this key, or NULL.
+  // The key ends at keyEnd and uses the escape sequences of JSON Pointer
+  // ("~0" for '~' and "~1" for '/').
+  static const char *findMember(const char *object, const char *key,
+                                const char *keyEnd) {
+    if (*object != '{') return NULL;
+    const char *s = skipSpacesAndComments(object + 1);
+    if (*s == '}') return NULL;
+
+    for (;;) {
+      bool match = keyEquals(s, key, keyEnd);
+      s = skipValue(s);  // a key has the syntax of a string or a token
+      if (!s) return NULL;
+
+      s = skipSpacesAndComments(s);
+      if (*s != ':') return NULL;
+      s = skipSpacesAndComments(s + 1);
+      if (match) return s;
+
+      s = skipValue(s);
+      if (!s) return NULL;
+      s = skipSpacesAndComments(s);
+      if (*s != ',') return NULL;
+      s = skipSpacesAndComments(s + 1);
+    }
+  }
+
+  // Returns the element at this position, or NULL
+  static const char *findElement(const char *array, size_t index) {
+    if (*array != '[') return NULL;
+    const char *s = skipSpacesAndComments(array + 1);
+    if (*s == ']') return NULL;
+
+    for (; index > 0; index--) {
+      s = skipValue(s);
+      if (!s) return NULL;
+      s = skipSpacesAndComments(s);
+      if (*s != ',') return NULL;
+      s = skipSpacesAndComments(s + 1);
+    }
+    return s;
+  }
+
+  // Copies the content of the string that starts at s, without the quotes
+  // and with the escape sequences replaced.
+  // Returns false if it doesn't fit in size bytes, with the terminator.
+  static bool unescapeString(const char *s, char *buffer, size_t size) {
+    char stopChar = *s++;
+    size_t length = 0;
+    for (;;) {
+      char c = *s++;
+      if (c == stopChar) break;
+      if (c == '\0') return false;
+      if (c == '\\') {
+        if (*s == '\0') return false;
+        c = Encoding::unescapeChar(*s++);
+      }
+      if (length + 1 >= size) return false;
+      buffer[length++] = c;
+    }
+    if (size == 0) return false;
+    buffer[length] = '\0';
+    return true;
+  }
+
+  // Returns true if the string that starts at s has the same content as the
+  // null-terminated string other.
+  static bool stringEquals(const char *s, const char *other) {
+    char stopChar = *s++;
+    for (;;) {
+      char c = *s++;
+      if (c == stopChar) return *other == '\0';
+      if (c == '\0') return false;
+      if (c == '\\') {
+        if (*s == '\0') return false;
+        c = Encoding::unescapeChar(*s++);
+      }
+      if (c != *other++) return false;
+    }
+  }
+
+ private:
+  static const char *skipContainer(const char *s) {
+    int depth = 0;
+    for (;;) {
+      switch (*s) {
+        case '\0':
+          return NULL;
+        case '{':
+        case '[':
+          depth++;
+          s++;
+          break;
+        case '}':
+        case ']':
+          s++;
+          if (--depth == 0) return s;
+          break;
+        case '\"':
+        case '\'':
+          s = skipString(s);
+          if (!s) return NULL;
+          break;
+        case '/':
+          s = skipComment(s);
+          break;
+        default:
+          s++;
+          break;
+      }
+    }
+  }
+
+  static const char *skipString(const char *s) {
+    char stopChar = *s++;
+    for (;;) {
+      s = StringScanner::findStringEnd(s, stopChar);
+      if (*s == stopChar) return s + 1;
+      if (*s == '\0' || s[1] == '\0') return NULL;
+      s += 2;  // escape sequence
+    }
+  }
+
+  static const char *skipBareToken(const char *s) {
+    const char *start = s;
+    while (isLetterOrNumber(*s)) s++;
+    return s == start ? NULL : s;
+  }
+
+  static const char *skipComment(const char *s) {
+    if (s[1] == '*') return skipCStyleComment(s);
+    if (s[1] == '/') return skipCppStyleComment(s);
+    return s + 1;
+  }
+
+  // Compares the key that starts at s (quoted or not) with a reference token
+  // of a JSON Pointer.
+  static bool keyEquals(const char *s, const char *key, const char *keyEnd) {
+    char stopChar = 0;
+    if (*s == '\"' || *s == '\'') stopChar = *s++;
+
+    for (;;) {
+      char c = *s++;
+      if (stopChar ? c == stopChar : !isLetterOrNumber(c)) break;
+      if (c == '\0') return false;
+      if (stopChar && c == '\\') {
+        if (*s == '\0') return false;
+        c = Encoding::unescapeChar(*s++);
+      }
+
+      if (key == keyEnd) return false;
+      char expected = *key++;
+      if (expected == '~' && key != keyEnd) {
+        expected = *key++ == '1' ? '/' : '~';
+      }
+      if (c != expected) return false;
+    }
+    return key == keyEnd;
+  }
+
+  // Same characters as the parser accepts in unquoted tokens
+  static bool isLetterOrNumber(char c) {
+    return ('0' <= c && c <= '9') || ('a' <= c && c <= 'z') ||
+           ('A' <= c && c <= 'Z') || c == '-' || c == '.';
+  }
+};
+}
+}
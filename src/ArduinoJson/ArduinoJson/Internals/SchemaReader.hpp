@@ -0,0 +1,79 @@
+// Copyright Benoit Blanchon 2014-2016
+// MIT License
+//
+// Arduino JSON library
+// https://github.com/bblanchon/ArduinoJson
+// If you like this project, please add a star!
+
+#pragma once
+
+#include "../JsonHandler.hpp"
+#include "../RawJson.hpp"
+#include "ParseRawValue.hpp"
+
+namespace ArduinoJson {
+namespace Internals {
+
+// A JsonHandler that stores the members of the root object in a struct.
+// Unknown keys are skipped, with their content.
+// This internal class is not indended to be used directly.
+// Instead, use JsonSchema::parse().
+template <typename TStruct, typename TFieldList>
+class SchemaReader : public JsonHandler {
+ public:
+  SchemaReader(const TFieldList &fields, TStruct &object)
+      : _fields(fields), _object(object), _depth(0), _field(-1),
+        _failed(false) {}
+
+  virtual void startObject() {
+    // the root must be an object, and a member can't be one
+    if (_depth == 1 && _field >= 0) _failed = true;
+    _depth++;
+  }
+
+  virtual void startArray() {
+    if (_depth == 0 || (_depth == 1 && _field >= 0)) _failed = true;
+    _depth++;
+  }
+
+  virtual void endObject() {
+    _depth--;
+  }
+
+  virtual void endArray() {
+    _depth--;
+  }
+
+  virtual void key(const char *key) {
+    if (_depth == 1) _field = _fields.indexOf(key);
+  }
+
+  virtual void value(const JsonVariant &value) {
+    if (_depth == 0) _failed = true;
+    if (_depth != 1 || _field < 0) return;
+
+    // the numbers and booleans are converted once, here, instead of in each
+    // call to is<T>() and as<T>()
+    JsonVariant converted;
+    if (value.is<RawJson>() && value.as<const char *>())
+      converted = parseRawValue(value.as<const char *>());
+    if (!converted.success()) converted = value;
+
+    if (!_fields.read(_object, _field, converted)) _failed = true;
+    _field = -1;
+  }
+
+  // Returns true if all the known members had the right type
+  bool success() const {
+    return !_failed;
+  }
+
+ private:
+  const TFieldList &_fields;
+  TStruct &_object;
+  uint8_t _depth;
+  int _field;  // the position of the current key in the list, or -1
+  bool _failed;
+};
+}
+}
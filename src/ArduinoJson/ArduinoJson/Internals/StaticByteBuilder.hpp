@@ -0,0 +1,47 @@
+// Copyright Benoit Blanchon 2014-2016
+// MIT License
+//
+// Arduino JSON library
+// https://github.com/bblanchon/ArduinoJson
+// If you like this project, please add a star!
+
+#pragma once
+
+#include "../Print.hpp"
+
+#include <string.h>  // for memcpy
+
+namespace ArduinoJson {
+namespace Internals {
+
+// A Print implementation that allows to write in a uint8_t[]
+// Unlike StaticStringBuilder, it doesn't add a terminator, because binary
+// data can contain zeros.
+class StaticByteBuilder : public Print {
+ public:
+  StaticByteBuilder(uint8_t *buf, size_t size)
+      : buffer(buf), capacity(size), length(0) {}
+
+  virtual size_t write(uint8_t c) {
+    if (length >= capacity) return 0;
+
+    buffer[length++] = c;
+    return 1;
+  }
+
+  virtual size_t write(const uint8_t *s, size_t n) {
+    size_t available = capacity - length;
+    if (n > available) n = available;
+
+    memcpy(buffer + length, s, n);
+    length += n;
+    return n;
+  }
+
+ private:
+  uint8_t *buffer;
+  size_t capacity;
+  size_t length;
+};
+}
+}
@@ -9,6 +9,8 @@
 
 #include "../Print.hpp"
 
+#include <string.h>  // for memcpy
+
 namespace ArduinoJson {
 namespace Internals {
 
@@ -28,6 +30,16 @@ class StaticStringBuilder : public Print {
     return 1;
   }
 
+  virtual size_t write(const uint8_t *s, size_t n) {
+    size_t available = capacity - length;
+    if (n > available) n = available;
+
+    memcpy(buffer + length, s, n);
+    length += n;
+    buffer[length] = '\0';
+    return n;
+  }
+
  private:
   char *buffer;
   size_t capacity;
@@ -0,0 +1,372 @@
+// Copyright Benoit Blanchon 2014-2016
+// MIT License
+//
+// Arduino JSON library
+// https://github.com/bblanchon/ArduinoJson
+// If you like this project, please add a star!
+
+#pragma once
+
+#include "../JsonHandler.hpp"
+#include "../JsonParseError.hpp"
+#include "../RawJson.hpp"
+#include "Encoding.hpp"
+#include "ParseRawValue.hpp"
+
+#include <stddef.h>  // for size_t
+#include <stdint.h>  // for uint32_t
+#include <stdlib.h>  // for realloc() and free()
+#include <string.h>  // for memcpy()
+
+namespace ArduinoJson {
+namespace Internals {
+
+// The state machine behind JsonStreamParser.
+// It reads the JSON one character at a time and only keeps the current token
+// and one bit per level of nesting, so the memory usage doesn't depend on the
+// size of the document.
+// This internal class is not indended to be used directly.
+// Instead, use JsonStreamParser<TOKEN_CAPACITY>.
+class StreamParser {
+ public:
+  // The nesting stack is a bitfield.
+  static const uint8_t MAX_NESTING_LIMIT = 31;
+
+  // Returns false if the JSON is invalid, or if a token or the nesting depth
+  // exceeds the limits.
+  bool parse(char c) {
+    if (!parseChar(c)) return false;
+    _offset++;
+    return true;
+  }
+
+  bool parse(const char *json, size_t length) {
+    while (length--) {
+      if (!parse(*json++)) return false;
+    }
+    return true;
+  }
+
+  bool parse(const char *json) {
+    while (*json) {
+      if (!parse(*json++)) return false;
+    }
+    return true;
+  }
+
+  // Tells that the input is complete.
+  // Returns true if exactly one valid JSON document was read.
+  bool finish() {
+    if (_state == STATE_BARE && !endToken()) return false;
+    if (_state == STATE_CPP_COMMENT) _state = _stateBeforeComment;
+    if (_state != STATE_DONE) return fail();
+    return true;
+  }
+
+  // Prepares the parser for the next document.
+  void reset() {
+    _state = STATE_VALUE;
+    _error = JsonParseError::OK;
+    _offset = 0;
+    _depth = 0;
+    _stack = 0;
+    _length = 0;
+    releaseToken();
+  }
+
+  // Lets the tokens longer than TOKEN_CAPACITY move to the heap, where the
+  // buffer doubles up to maxSize, including the terminator.
+  // The buffer is freed by reset().
+  void setMaxTokenSize(size_t maxSize) {
+    _maxCapacity = maxSize;
+  }
+
+  bool failed() const {
+    return _state == STATE_ERROR;
+  }
+
+  // Why the parser failed, and after how many characters.
+  // A token longer than the largest buffer gives NO_MEMORY.
+  JsonParseError error() const {
+    return JsonParseError(static_cast<JsonParseError::Code>(_error), _offset);
+  }
+
+ protected:
+  StreamParser(JsonHandler &handler, char *token, size_t capacity,
+               uint8_t nestingLimit)
+      : _handler(handler),
+        _token(token),
+        _inlineToken(token),
+        _capacity(capacity),
+        _inlineCapacity(capacity),
+        _maxCapacity(capacity),
+        _nestingLimit(nestingLimit < MAX_NESTING_LIMIT ? nestingLimit
+                                                         : MAX_NESTING_LIMIT) {
+    reset();
+  }
+
+  ~StreamParser() {
+    releaseToken();
+  }
+
+ private:
+  // the heap buffer can't be shared
+  StreamParser(const StreamParser &);
+  StreamParser &operator=(const StreamParser &);
+
+  bool parseChar(char c) {
+    switch (_state) {
+      case STATE_ERROR:
+        return false;
+
+      case STATE_STRING:
+        if (c == _stopChar) return endToken();
+        if (c == '\\') {
+          _state = STATE_STRING_ESCAPE;
+          return true;
+        }
+        if (c == '\0') return fail();
+        return append(c);
+
+      case STATE_STRING_ESCAPE:
+        _state = STATE_STRING;
+        if (c == '\0') return fail();
+        return append(Encoding::unescapeChar(c));
+
+      case STATE_BARE:
+        if (isLetterOrNumber(c)) return append(c);
+        if (!endToken()) return false;
+        break;  // c is the first character after the token
+
+      case STATE_COMMENT_START:
+        if (c == '*') {
+          _state = STATE_C_COMMENT;
+        } else if (c == '/') {
+          _state = STATE_CPP_COMMENT;
+        } else {
+          return fail();
+        }
+        return true;
+
+      case STATE_C_COMMENT:
+        if (c == '*') _state = STATE_C_COMMENT_STAR;
+        return true;
+
+      case STATE_C_COMMENT_STAR:
+        if (c == '/') {
+          _state = _stateBeforeComment;
+        } else if (c != '*') {
+          _state = STATE_C_COMMENT;
+        }
+        return true;
+
+      case STATE_CPP_COMMENT:
+        if (c == '\n') _state = _stateBeforeComment;
+        return true;
+
+      default:
+        break;
+    }
+
+    return parseStructure(c);
+  }
+
+  enum State {
+    STATE_VALUE,        // expecting a value
+    STATE_ARRAY_FIRST,  // expecting a value or ']'
+    STATE_OBJECT_FIRST, // expecting a key or '}'
+    STATE_KEY,          // expecting a key
+    STATE_COLON,        // expecting ':'
+    STATE_AFTER_VALUE,  // expecting ',', ']' or '}'
+    STATE_DONE,         // the document is complete
+    STATE_STRING,
+    STATE_STRING_ESCAPE,
+    STATE_BARE,  // unquoted token: number, boolean, null or key
+    STATE_COMMENT_START,
+    STATE_C_COMMENT,
+    STATE_C_COMMENT_STAR,
+    STATE_CPP_COMMENT,
+    STATE_ERROR
+  };
+
+  // Handles a character that is not part of a string, a token or a comment
+  bool parseStructure(char c) {
+    if (c == ' ' || c == '\t' || c == '\r' || c == '\n') return true;
+
+    if (c == '/') {
+      _stateBeforeComment = _state;
+      _state = STATE_COMMENT_START;
+      return true;
+    }
+
+    switch (_state) {
+      case STATE_ARRAY_FIRST:
+        if (c == ']') return endArray();
+      // fall through
+      case STATE_VALUE:
+        // as JsonBuffer::parseObject(): a value, even a number or a string,
+        // may be nested in at most nestingLimit containers
+        if (_depth > _nestingLimit) return fail(JsonParseError::TOO_DEEP);
+        if (c == '{') {
+          push(true);
+          _handler.startObject();
+          _state = STATE_OBJECT_FIRST;
+          return true;
+        }
+        if (c == '[') {
+          push(false);
+          _handler.startArray();
+          _state = STATE_ARRAY_FIRST;
+          return true;
+        }
+        return startToken(c, false);
+
+      case STATE_OBJECT_FIRST:
+        if (c == '}') return endObject();
+      // fall through
+      case STATE_KEY:
+        return startToken(c, true);
+
+      case STATE_COLON:
+        if (c != ':') return fail();
+        _state = STATE_VALUE;
+        return true;
+
+      case STATE_AFTER_VALUE:
+        if (c == ',') {
+          _state = isInObject() ? STATE_KEY : STATE_VALUE;
+          return true;
+        }
+        if (c == '}' && isInObject()) return endObject();
+        if (c == ']' && !isInObject()) return endArray();
+        return fail();
+
+      default:
+        return fail();
+    }
+  }
+
+  bool startToken(char c, bool isKey) {
+    _isKey = isKey;
+    _length = 0;
+    if (c == '\'' || c == '\"') {
+      _stopChar = c;
+      _state = STATE_STRING;
+      return true;
+    }
+    if (!isLetterOrNumber(c)) return fail();
+    _stopChar = 0;
+    _state = STATE_BARE;
+    return append(c);
+  }
+
+  bool endToken() {
+    _token[_length] = '\0';
+    if (_isKey) {
+      _handler.key(_token);
+      _state = STATE_COLON;
+      return true;
+    }
+    if (_stopChar) {
+      _handler.value(JsonVariant(static_cast<const char *>(_token)));
+    } else {
+#if ARDUINOJSON_ENABLE_EAGER_PARSING
+      JsonVariant value = parseRawValue(_token);
+      if (!value.success()) value = RawJson(_token);
+      _handler.value(value);
+#else
+      _handler.value(RawJson(_token));
+#endif
+    }
+    return endValue();
+  }
+
+  bool append(char c) {
+    // keep room for the terminator
+    if (_length + 1 >= _capacity && !growToken())
+      return fail(JsonParseError::NO_MEMORY);
+    _token[_length++] = c;
+    return true;
+  }
+
+  bool growToken() {
+    size_t capacity = _capacity * 2;
+    if (capacity > _maxCapacity) capacity = _maxCapacity;
+    if (capacity <= _capacity) return false;
+    bool isInline = _token == _inlineToken;
+    char *token =
+        static_cast<char *>(realloc(isInline ? NULL : _token, capacity));
+    if (token == NULL) return false;
+    if (isInline) memcpy(token, _inlineToken, _length);
+    _token = token;
+    _capacity = capacity;
+    return true;
+  }
+
+  void releaseToken() {
+    if (_token != _inlineToken) free(_token);
+    _token = _inlineToken;
+    _capacity = _inlineCapacity;
+  }
+
+  void push(bool isObject) {
+    _stack = (_stack << 1) | (isObject ? 1 : 0);
+    _depth++;
+  }
+
+  bool endObject() {
+    _handler.endObject();
+    return pop();
+  }
+
+  bool endArray() {
+    _handler.endArray();
+    return pop();
+  }
+
+  bool pop() {
+    _stack >>= 1;
+    _depth--;
+    return endValue();
+  }
+
+  bool endValue() {
+    _state = _depth ? STATE_AFTER_VALUE : STATE_DONE;
+    return true;
+  }
+
+  bool isInObject() const {
+    return (_stack & 1) != 0;
+  }
+
+  // Keeps the first error
+  bool fail(JsonParseError::Code error = JsonParseError::INVALID_INPUT) {
+    if (_state != STATE_ERROR) _error = static_cast<uint8_t>(error);
+    _state = STATE_ERROR;
+    return false;
+  }
+
+  static bool isLetterOrNumber(char c) {
+    return ('0' <= c && c <= '9') || ('a' <= c && c <= 'z') ||
+           ('A' <= c && c <= 'Z') || c == '-' || c == '.';
+  }
+
+  JsonHandler &_handler;
+  char *_token;
+  char *_inlineToken;
+  size_t _capacity;
+  size_t _inlineCapacity;
+  size_t _maxCapacity;
+  size_t _length;
+  size_t _offset;  // the characters read, up to the error
+  uint32_t _stack;  // one bit per level, 1 for an object, 0 for an array
+  uint8_t _depth;
+  uint8_t _nestingLimit;
+  uint8_t _state;
+  uint8_t _stateBeforeComment;
+  uint8_t _error;  // a JsonParseError::Code
+  char _stopChar;  // the quote, or 0 for an unquoted token
+  bool _isKey;
+};
+}
+}
@@ -0,0 +1,210 @@
+// Copyright Benoit Blanchon 2014-2016
+// MIT License
+//
+// Arduino JSON library
+// https://github.com/bblanchon/ArduinoJson
+// If you like this project, please add a star!
+
+#pragma once
+
+#include "../Configuration.hpp"
+#include "Encoding.hpp"
+
+#include <stdint.h>
+
+#if ARDUINOJSON_ENABLE_AVX2
+#include <immintrin.h>
+#elif ARDUINOJSON_ENABLE_SSE2
+#include <emmintrin.h>
+#elif ARDUINOJSON_ENABLE_NEON
+#include <arm_neon.h>
+#endif
+
+#if ARDUINOJSON_ENABLE_AVX2 || ARDUINOJSON_ENABLE_SSE2 || \
+    ARDUINOJSON_ENABLE_NEON
+#define ARDUINOJSON_STRING_SCANNER_VECTORIZED 1
+#else
+#define ARDUINOJSON_STRING_SCANNER_VECTORIZED 0
+#endif
+
+namespace ArduinoJson {
+namespace Internals {
+
+// Finds the end of runs of characters that the writer and the parser can
+// process in bulk.
+//
+// On the computer, the vectorized versions read aligned 16-byte (SSE2, NEON)
+// or 32-byte (AVX2) blocks. An aligned block never crosses a page boundary, so
+// they can safely look at bytes beyond the null-terminator, just like the C
+// library's strlen().
+// On the microcontroller, they are plain loops.
+class StringScanner {
+ public:
+  // Returns a pointer to the first character of s that must be escaped in a
+  // JSON string (quote, backslash, control character) or to the terminator.
+  static const char *findEscapable(const char *s) {
+#if ARDUINOJSON_STRING_SCANNER_VECTORIZED
+    return find(s, EscapableMatcher());
+#else
+    while (!Encoding::escapeChar(*s)) s++;
+    return s;
+#endif
+  }
+
+  // Returns a pointer to the first occurence of stopChar, of a backslash or
+  // of the terminator in s.
+  static const char *findStringEnd(const char *s, char stopChar) {
+#if ARDUINOJSON_STRING_SCANNER_VECTORIZED
+    StringEndMatcher matcher = {stopChar};
+    return find(s, matcher);
+#else
+    while (*s != stopChar && *s != '\\' && *s != '\0') s++;
+    return s;
+#endif
+  }
+
+  // Returns a pointer to the first character of s that is not a space, a tab
+  // or a line break.
+  static const char *skipSpaces(const char *s) {
+#if ARDUINOJSON_STRING_SCANNER_VECTORIZED
+    return find(s, NonSpaceMatcher());
+#else
+    while (*s == ' ' || *s == '\t' || *s == '\r' || *s == '\n') s++;
+    return s;
+#endif
+  }
+
+#if ARDUINOJSON_STRING_SCANNER_VECTORIZED
+ private:
+#if ARDUINOJSON_ENABLE_AVX2
+  typedef __m256i Block;
+  typedef uint32_t Mask;
+  static const uintptr_t BLOCK_SIZE = 32;
+  static const int MASK_BITS_PER_BYTE = 1;
+
+  static Block load(const char *p) {
+    return _mm256_load_si256(reinterpret_cast<const __m256i *>(p));
+  }
+  static Block equals(Block x, char c) {
+    return _mm256_cmpeq_epi8(x, _mm256_set1_epi8(c));
+  }
+  // unsigned comparison: x < c <=> min(x, c - 1) == x
+  static Block lowerThan(Block x, char c) {
+    return _mm256_cmpeq_epi8(_mm256_min_epu8(x, _mm256_set1_epi8(char(c - 1))),
+                             x);
+  }
+  static Block either(Block a, Block b) {
+    return _mm256_or_si256(a, b);
+  }
+  static Block negate(Block x) {
+    return _mm256_xor_si256(x, _mm256_set1_epi8(-1));
+  }
+  static Mask toMask(Block x) {
+    return static_cast<Mask>(_mm256_movemask_epi8(x));
+  }
+#elif ARDUINOJSON_ENABLE_SSE2
+  typedef __m128i Block;
+  typedef uint32_t Mask;
+  static const uintptr_t BLOCK_SIZE = 16;
+  static const int MASK_BITS_PER_BYTE = 1;
+
+  static Block load(const char *p) {
+    return _mm_load_si128(reinterpret_cast<const __m128i *>(p));
+  }
+  static Block equals(Block x, char c) {
+    return _mm_cmpeq_epi8(x, _mm_set1_epi8(c));
+  }
+  // unsigned comparison: x < c <=> min(x, c - 1) == x
+  static Block lowerThan(Block x, char c) {
+    return _mm_cmpeq_epi8(_mm_min_epu8(x, _mm_set1_epi8(char(c - 1))), x);
+  }
+  static Block either(Block a, Block b) {
+    return _mm_or_si128(a, b);
+  }
+  static Block negate(Block x) {
+    return _mm_xor_si128(x, _mm_set1_epi8(-1));
+  }
+  static Mask toMask(Block x) {
+    return static_cast<Mask>(_mm_movemask_epi8(x));
+  }
+#else  // ARDUINOJSON_ENABLE_NEON
+  typedef uint8x16_t Block;
+  typedef uint64_t Mask;
+  static const uintptr_t BLOCK_SIZE = 16;
+  static const int MASK_BITS_PER_BYTE = 4;
+
+  static Block load(const char *p) {
+    return vld1q_u8(reinterpret_cast<const uint8_t *>(p));
+  }
+  static Block equals(Block x, char c) {
+    return vceqq_u8(x, vdupq_n_u8(static_cast<uint8_t>(c)));
+  }
+  static Block lowerThan(Block x, char c) {
+    return vcltq_u8(x, vdupq_n_u8(static_cast<uint8_t>(c)));
+  }
+  static Block either(Block a, Block b) {
+    return vorrq_u8(a, b);
+  }
+  static Block negate(Block x) {
+    return vmvnq_u8(x);
+  }
+  // NEON has no movemask: narrow each 0x00/0xFF byte to a nibble instead
+  static Mask toMask(Block x) {
+    const uint8x8_t nibbles = vshrn_n_u16(vreinterpretq_u16_u8(x), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(nibbles), 0);
+  }
+#endif
+
+  static int lowestBit(uint32_t mask) {
+    return __builtin_ctz(mask);
+  }
+  static int lowestBit(uint64_t mask) {
+    return __builtin_ctzll(mask);
+  }
+
+  // Returns a pointer to the first byte for which the matcher is true.
+  // The matcher must be true for the terminator, otherwise the loop would run
+  // past the end of the string.
+  template <typename TMatcher>
+  static const char *find(const char *s, const TMatcher &matcher) {
+    const uintptr_t offset = reinterpret_cast<uintptr_t>(s) & (BLOCK_SIZE - 1);
+    const char *block = s - offset;
+    // ignore the bytes of the first block that are before s
+    Mask mask = toMask(matcher(load(block))) &
+                (~Mask(0) << (offset * MASK_BITS_PER_BYTE));
+    while (!mask) {
+      block += BLOCK_SIZE;
+      mask = toMask(matcher(load(block)));
+    }
+    return block + lowestBit(mask) / MASK_BITS_PER_BYTE;
+  }
+
+  // Quote, backslash or control character (including the terminator)
+  struct EscapableMatcher {
+    Block operator()(Block x) const {
+      return either(either(equals(x, '\"'), equals(x, '\\')),
+                    lowerThan(x, 0x20));
+    }
+  };
+
+  // Closing quote, backslash or terminator
+  struct StringEndMatcher {
+    char stopChar;
+
+    Block operator()(Block x) const {
+      return either(either(equals(x, stopChar), equals(x, '\\')),
+                    equals(x, '\0'));
+    }
+  };
+
+  // Anything but a space, a tab or a line break
+  struct NonSpaceMatcher {
+    Block operator()(Block x) const {
+      return negate(either(either(equals(x, ' '), equals(x, '\t')),
+                           either(equals(x, '\r'), equals(x, '\n'))));
+    }
+  };
+#endif
+};
+}
+}
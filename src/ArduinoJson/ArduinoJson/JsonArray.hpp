@@ -187,6 +187,13 @@ class JsonArray : public Internals::JsonPrintable<JsonArray>,
     writer.endArray();
   }
 
+  // Serialize the array to a MsgPackWriter
+  void writeTo(Internals::MsgPackWriter &writer) const {
+    writer.beginArray(size());
+    for (const node_type *child = _firstNode; child; child = child->next)
+      child->content.writeTo(writer);
+  }
+
   // Imports a 1D array
   template <typename T, size_t N>
   bool copyFrom(T(&array)[N]) {
@@ -11,9 +11,22 @@
 #include <stdint.h>  // for uint8_t
 #include <string.h>
 
+#include "Configuration.hpp"
+#include "JsonBufferStats.hpp"
+#include "JsonParseError.hpp"
 #include "JsonVariant.hpp"
 #include "String.hpp"
 
+// Returns the size (in bytes) of the copy of a string of n characters, as
+// made by JsonBuffer::strdup() and by parseObject() with a const char* or a
+// String. Can be very handy to determine the size of a StaticJsonBuffer.
+#if ARDUINOJSON_ENABLE_ALIGNMENT
+#define JSON_STRING_SIZE(NUMBER_OF_CHARACTERS) \
+  (((NUMBER_OF_CHARACTERS) + sizeof(void *)) & ~(sizeof(void *) - 1))
+#else
+#define JSON_STRING_SIZE(NUMBER_OF_CHARACTERS) ((NUMBER_OF_CHARACTERS) + 1)
+#endif
+
 #if defined(__clang__)
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wnon-virtual-dtor"
@@ -113,6 +126,43 @@ class JsonBuffer {
     return parse(json.c_str(), nesting);
   }
 
+  // Same as parseArray(), parseObject() and parse(), and tells why they
+  // failed in error. When error.noMemory() is true, the JSON may be valid:
+  // JsonSpan::capacity() gives the size of the JsonBuffer it needs.
+  JsonArray &parseArray(char *json, JsonParseError &error,
+                        uint8_t nestingLimit = DEFAULT_LIMIT);
+  JsonArray &parseArray(const char *json, JsonParseError &error,
+                        uint8_t nesting = DEFAULT_LIMIT);
+  JsonArray &parseArray(const String &json, JsonParseError &error,
+                        uint8_t nesting = DEFAULT_LIMIT) {
+    return parseArray(json.c_str(), error, nesting);
+  }
+
+  JsonObject &parseObject(char *json, JsonParseError &error,
+                          uint8_t nestingLimit = DEFAULT_LIMIT);
+  JsonObject &parseObject(const char *json, JsonParseError &error,
+                          uint8_t nesting = DEFAULT_LIMIT);
+  JsonObject &parseObject(const String &json, JsonParseError &error,
+                          uint8_t nesting = DEFAULT_LIMIT) {
+    return parseObject(json.c_str(), error, nesting);
+  }
+
+  JsonVariant parse(char *json, JsonParseError &error,
+                    uint8_t nestingLimit = DEFAULT_LIMIT);
+  JsonVariant parse(const char *json, JsonParseError &error,
+                    uint8_t nesting = DEFAULT_LIMIT);
+  JsonVariant parse(const String &json, JsonParseError &error,
+                    uint8_t nesting = DEFAULT_LIMIT) {
+    return parse(json.c_str(), error, nesting);
+  }
+
+  // Same as parse() with MessagePack data instead of JSON text.
+  // The data is not modified, strings are copied in the JsonBuffer.
+  // Returns an undefined JsonVariant if the data is invalid, or if it contains
+  // binary or extension types, or if the buffer is too small.
+  JsonVariant parseMsgPack(const uint8_t *data, size_t size,
+                           uint8_t nestingLimit = DEFAULT_LIMIT);
+
   // Duplicate a string
   char *strdup(const char *src) {
     return src ? strdup(src, strlen(src)) : NULL;
@@ -123,6 +173,36 @@ class JsonBuffer {
   // Return a pointer to the allocated memory or NULL if allocation fails.
   virtual void *alloc(size_t size) = 0;
 
+  // Same as alloc(), for a JsonArray, a JsonObject or an element of them.
+  void *allocNode(size_t size) {
+    void *p = alloc(size);
+#if ARDUINOJSON_ENABLE_MEMORY_STATS
+    record(p, size, _stats.nodeBytes);
+#endif
+    return p;
+  }
+
+  // Same as alloc(), for a string.
+  char *allocString(size_t size) {
+    void *p = alloc(size);
+#if ARDUINOJSON_ENABLE_MEMORY_STATS
+    record(p, size, _stats.stringBytes);
+#endif
+    return static_cast<char *>(p);
+  }
+
+#if ARDUINOJSON_ENABLE_MEMORY_STATS
+  // Returns what was allocated through allocNode() and allocString().
+  // Call resetStats() between documents to get the numbers of each one.
+  const JsonBufferStats &stats() const {
+    return _stats;
+  }
+
+  void resetStats() {
+    _stats = JsonBufferStats();
+  }
+#endif
+
  protected:
   // Preserve aligment if nessary
   static FORCE_INLINE size_t round_size_up(size_t bytes) {
@@ -135,6 +215,20 @@ class JsonBuffer {
   }
 
  private:
+#if ARDUINOJSON_ENABLE_MEMORY_STATS
+  void record(void *p, size_t size, size_t &counter) {
+    if (!p) {
+      _stats.failedAllocations++;
+      return;
+    }
+    counter += round_size_up(size);
+    size_t used = _stats.usedBytes();
+    if (used > _stats.peakBytes) _stats.peakBytes = used;
+  }
+
+  JsonBufferStats _stats;
+#endif
+
   char *strdup(const char *, size_t);
 
   // Default value of nesting limit of parseArray() and parseObject().
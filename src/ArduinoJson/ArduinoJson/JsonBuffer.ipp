@@ -8,6 +8,7 @@
 #pragma once
 
 #include "Internals/JsonParser.hpp"
+#include "Internals/MsgPackParser.hpp"
 
 inline ArduinoJson::JsonArray &ArduinoJson::JsonBuffer::createArray() {
   JsonArray *ptr = new (this) JsonArray(this);
@@ -37,10 +38,71 @@ inline ArduinoJson::JsonVariant ArduinoJson::JsonBuffer::parse(
   return parser.parseVariant();
 }
 
+inline ArduinoJson::JsonArray &ArduinoJson::JsonBuffer::parseArray(
+    char *json, JsonParseError &error, uint8_t nestingLimit) {
+  Internals::JsonParser parser(this, json, nestingLimit);
+  JsonArray &array = parser.parseArray();
+  error = parser.error();
+  return array;
+}
+
+// The copy of the input is the first allocation that can fail
+inline ArduinoJson::JsonArray &ArduinoJson::JsonBuffer::parseArray(
+    const char *json, JsonParseError &error, uint8_t nesting) {
+  char *copy = strdup(json);
+  if (json && !copy) {
+    error = JsonParseError(JsonParseError::NO_MEMORY, 0);
+    return JsonArray::invalid();
+  }
+  return parseArray(copy, error, nesting);
+}
+
+inline ArduinoJson::JsonObject &ArduinoJson::JsonBuffer::parseObject(
+    char *json, JsonParseError &error, uint8_t nestingLimit) {
+  Internals::JsonParser parser(this, json, nestingLimit);
+  JsonObject &object = parser.parseObject();
+  error = parser.error();
+  return object;
+}
+
+inline ArduinoJson::JsonObject &ArduinoJson::JsonBuffer::parseObject(
+    const char *json, JsonParseError &error, uint8_t nesting) {
+  char *copy = strdup(json);
+  if (json && !copy) {
+    error = JsonParseError(JsonParseError::NO_MEMORY, 0);
+    return JsonObject::invalid();
+  }
+  return parseObject(copy, error, nesting);
+}
+
+inline ArduinoJson::JsonVariant ArduinoJson::JsonBuffer::parse(
+    char *json, JsonParseError &error, uint8_t nestingLimit) {
+  Internals::JsonParser parser(this, json, nestingLimit);
+  JsonVariant variant = parser.parseVariant();
+  error = parser.error();
+  return variant;
+}
+
+inline ArduinoJson::JsonVariant ArduinoJson::JsonBuffer::parse(
+    const char *json, JsonParseError &error, uint8_t nesting) {
+  char *copy = strdup(json);
+  if (json && !copy) {
+    error = JsonParseError(JsonParseError::NO_MEMORY, 0);
+    return JsonVariant();
+  }
+  return parse(copy, error, nesting);
+}
+
+inline ArduinoJson::JsonVariant ArduinoJson::JsonBuffer::parseMsgPack(
+    const uint8_t *data, size_t size, uint8_t nestingLimit) {
+  Internals::MsgPackParser parser(this, data, size, nestingLimit);
+  return parser.parseVariant();
+}
+
 inline char *ArduinoJson::JsonBuffer::strdup(const char *source,
                                              size_t length) {
   size_t size = length + 1;
-  char *dest = static_cast<char *>(alloc(size));
+  char *dest = allocString(size);
   if (dest != NULL) memcpy(dest, source, size);
   return dest;
 }
@@ -0,0 +1,38 @@
+// Copyright Benoit Blanchon 2014-2016
+// MIT License
+//
+// Arduino JSON library
+// https://github.com/bblanchon/ArduinoJson
+// If you like this project, please add a star!
+
+#pragma once
+
+#include <stddef.h>  // for size_t
+
+namespace ArduinoJson {
+
+// What a JsonBuffer allocated, as returned by JsonBuffer::stats().
+// Only available when ARDUINOJSON_ENABLE_MEMORY_STATS is set.
+// The sizes include the padding added for the alignment.
+struct JsonBufferStats {
+  JsonBufferStats()
+      : nodeBytes(0), stringBytes(0), peakBytes(0), failedAllocations(0) {}
+
+  // The memory used by the JsonArrays, the JsonObjects and their elements
+  size_t nodeBytes;
+
+  // The memory used by the strings: the copies made by strdup(), and the
+  // input of parseObject() and parseArray() when it's not a char*
+  size_t stringBytes;
+
+  // The highest value of usedBytes() since the last resetStats()
+  size_t peakBytes;
+
+  // The number of allocations that returned NULL because the buffer was full
+  size_t failedAllocations;
+
+  size_t usedBytes() const {
+    return nodeBytes + stringBytes;
+  }
+};
+}
@@ -0,0 +1,28 @@
+// Copyright Benoit Blanchon 2014-2016
+// MIT License
+//
+// Arduino JSON library
+// https://github.com/bblanchon/ArduinoJson
+// If you like this project, please add a star!
+
+#pragma once
+
+namespace ArduinoJson {
+
+// Binds a JSON key to a member of a struct.
+// It's an entry of a JsonSchema and is normally created with jsonField().
+template <typename TStruct, typename TMember>
+struct JsonField {
+  const char *name;
+  TMember TStruct::*member;
+};
+
+// Creates a JsonField, the types are deduced from the member pointer:
+//
+//   jsonField("power", &Light::power)
+template <typename TStruct, typename TMember>
+constexpr JsonField<TStruct, TMember> jsonField(const char *name,
+                                                TMember TStruct::*member) {
+  return JsonField<TStruct, TMember>{name, member};
+}
+}
@@ -0,0 +1,32 @@
+// Copyright Benoit Blanchon 2014-2016
+// MIT License
+//
+// Arduino JSON library
+// https://github.com/bblanchon/ArduinoJson
+// If you like this project, please add a star!
+
+#pragma once
+
+#include "JsonVariant.hpp"
+
+namespace ArduinoJson {
+
+// Receives the events of a JsonStreamParser.
+// Override the members you're interested in, the others do nothing.
+// The strings passed to key() and value() are only valid during the call.
+class JsonHandler {
+ public:
+  virtual ~JsonHandler() {}
+
+  virtual void startObject() {}
+  virtual void endObject() {}
+  virtual void startArray() {}
+  virtual void endArray() {}
+
+  // Called with the name of each member of an object, before its value.
+  virtual void key(const char* /*key*/) {}
+
+  // Called for each string, number, boolean or null.
+  virtual void value(const JsonVariant& /*value*/) {}
+};
+}
@@ -0,0 +1,102 @@
+// Copyright Benoit Blanchon 2014-2016
+// MIT License
+//
+// Arduino JSON library
+// https://github.com/bblanchon/ArduinoJson
+// If you like this project, please add a star!
+
+#pragma once
+
+#include "Internals/Comments.hpp"
+#include "Internals/StringScanner.hpp"
+
+#include <stddef.h>  // for size_t
+#include <string.h>  // for memmove
+
+namespace ArduinoJson {
+namespace Internals {
+
+// Removes the spaces and comments of a JSON text, in place, in a single pass.
+// This internal class is not indended to be used directly.
+// Instead, use minifyJson().
+class JsonMinifier {
+ public:
+  static size_t minify(char *json) {
+    const char *readPtr = json;
+    char *writePtr = json;
+
+    for (;;) {
+      switch (*readPtr) {
+        case '\0':
+          *writePtr = '\0';
+          return static_cast<size_t>(writePtr - json);
+
+        case ' ':
+        case '\t':
+        case '\r':
+        case '\n':
+        case '/': {
+          const char *next = skipSpacesAndComments(readPtr);
+          if (next == readPtr) {  // a slash that doesn't start a comment
+            *writePtr++ = *readPtr++;
+            break;
+          }
+          // two tokens must stay apart, or "1 2" would become "12"
+          if (writePtr > json && isLetterOrNumber(writePtr[-1]) &&
+              isLetterOrNumber(*next))
+            *writePtr++ = ' ';
+          readPtr = next;
+          break;
+        }
+
+        case '\"':
+        case '\'':
+          copyString(readPtr, writePtr);
+          break;
+
+        default:
+          *writePtr++ = *readPtr++;
+          break;
+      }
+    }
+  }
+
+ private:
+  // Copies a string literal as it is, quotes and escape sequences included
+  static void copyString(const char *&readPtr, char *&writePtr) {
+    char stopChar = *readPtr;
+    *writePtr++ = *readPtr++;
+    for (;;) {
+      const char *runEnd = StringScanner::findStringEnd(readPtr, stopChar);
+      size_t runLength = static_cast<size_t>(runEnd - readPtr);
+      memmove(writePtr, readPtr, runLength);
+      writePtr += runLength;
+      readPtr = runEnd;
+
+      if (*readPtr == '\0') return;
+      *writePtr++ = *readPtr++;  // the closing quote, or the backslash
+      if (readPtr[-1] == stopChar) return;
+      if (*readPtr == '\0') return;
+      *writePtr++ = *readPtr++;  // the escaped character
+    }
+  }
+
+  // Same characters as the parser accepts in unquoted tokens
+  static bool isLetterOrNumber(char c) {
+    return ('0' <= c && c <= '9') || ('a' <= c && c <= 'z') ||
+           ('A' <= c && c <= 'Z') || c == '-' || c == '.';
+  }
+};
+}
+
+// Removes the spaces, the line breaks and the comments of a JSON text, in
+// place, without touching the content of the strings.
+// Returns the new length; the text is null-terminated there.
+// Nothing is allocated, so the caller decides how long the text lives:
+//
+//   char json[] = "{ \"power\" : true }";
+//   size_t length = minifyJson(json);  // {"power":true}
+inline size_t minifyJson(char *json) {
+  return json ? Internals::JsonMinifier::minify(json) : 0;
+}
+}
@@ -163,6 +163,15 @@ class JsonObject : public Internals::JsonPrintable<JsonObject>,
     writer.endObject();
   }
 
+  // Serialize the object to a MsgPackWriter
+  void writeTo(Internals::MsgPackWriter& writer) const {
+    writer.beginObject(size());
+    for (const node_type* node = _firstNode; node; node = node->next) {
+      writer.writeString(node->content.key);
+      node->content.value.writeTo(writer);
+    }
+  }
+
  private:
   // Returns the list node that matches the specified key.
   node_type* getNodeAt(const char* key) const {
@@ -0,0 +1,68 @@
+// Copyright Benoit Blanchon 2014-2016
+// MIT License
+//
+// Arduino JSON library
+// https://github.com/bblanchon/ArduinoJson
+// If you like this project, please add a star!
+
+#pragma once
+
+#include <stddef.h>  // for size_t
+
+namespace ArduinoJson {
+
+// Why parseArray(), parseObject() or parse() failed, and where.
+//
+//   JsonParseError error;
+//   JsonObject& root = jsonBuffer.parseObject(json, error);
+//   if (error.noMemory()) ...
+class JsonParseError {
+ public:
+  enum Code {
+    OK,
+    INVALID_INPUT,  // the JSON is invalid, or the root has the wrong type
+    NO_MEMORY,      // the JsonBuffer is too small
+    TOO_DEEP        // the nesting limit is reached
+  };
+
+  JsonParseError() : _code(OK), _offset(0) {}
+  JsonParseError(Code code, size_t offset) : _code(code), _offset(offset) {}
+
+  Code code() const {
+    return _code;
+  }
+
+  // The position in the input where the parser stopped
+  size_t offset() const {
+    return _offset;
+  }
+
+  bool success() const {
+    return _code == OK;
+  }
+
+  // Returns true if the input may be valid and only the memory was missing:
+  // parsing again in a larger JsonBuffer may succeed. Remember that a char*
+  // input is modified by the parser; parse a new copy.
+  bool noMemory() const {
+    return _code == NO_MEMORY;
+  }
+
+  const char *c_str() const {
+    switch (_code) {
+      case OK:
+        return "OK";
+      case INVALID_INPUT:
+        return "InvalidInput";
+      case NO_MEMORY:
+        return "NoMemory";
+      default:
+        return "TooDeep";
+    }
+  }
+
+ private:
+  Code _code;
+  size_t _offset;
+};
+}
@@ -0,0 +1,109 @@
+// Copyright Benoit Blanchon 2014-2016
+// MIT License
+//
+// Arduino JSON library
+// https://github.com/bblanchon/ArduinoJson
+// If you like this project, please add a star!
+
+#pragma once
+
+#include "Configuration.hpp"
+
+#if ARDUINOJSON_ENABLE_SCHEMA
+
+#include "Internals/DummyPrint.hpp"
+#include "Internals/DynamicStringBuilder.hpp"
+#include "Internals/JsonFieldList.hpp"
+#include "Internals/JsonWriter.hpp"
+#include "Internals/SchemaReader.hpp"
+#include "Internals/StaticStringBuilder.hpp"
+#include "JsonField.hpp"
+#include "JsonStreamParser.hpp"
+
+namespace ArduinoJson {
+
+// Writes a struct as a JSON object, and reads it back, without a JsonBuffer.
+// The fields are listed once, usually in a constexpr variable so that the
+// table and its keys stay in flash:
+//
+//   struct Light {
+//     bool power;
+//     char status[16];
+//   };
+//
+//   constexpr auto lightSchema = makeJsonSchema(
+//       jsonField("power", &Light::power),
+//       jsonField("status", &Light::status));
+//
+//   lightSchema.printTo(light, Serial);
+//   lightSchema.parse(json, light);
+//
+// The members can be bool, integers, floats, char arrays and const char*.
+// Any other type is a compilation error, and so is reading a const char*.
+// The object is written on a single line, in the order of the fields.
+template <typename TStruct, typename... TMembers>
+class JsonSchema : public Internals::JsonFieldList<TStruct, TMembers...> {
+  typedef Internals::JsonFieldList<TStruct, TMembers...> base_type;
+
+ public:
+  constexpr explicit JsonSchema(JsonField<TStruct, TMembers>... fields)
+      : base_type(fields...) {}
+
+  size_t printTo(const TStruct &object, Print &print) const {
+    Internals::JsonWriter writer(print);
+    writer.beginObject();
+    this->writeTo(object, writer);
+    writer.endObject();
+    return writer.bytesWritten();
+  }
+
+  size_t printTo(const TStruct &object, char *buffer,
+                 size_t bufferSize) const {
+    Internals::StaticStringBuilder sb(buffer, bufferSize);
+    return printTo(object, sb);
+  }
+
+  size_t printTo(const TStruct &object, String &str) const {
+    Internals::DynamicStringBuilder sb(str);
+    return printTo(object, sb);
+  }
+
+  size_t measureLength(const TStruct &object) const {
+    Internals::DummyPrint dp;
+    return printTo(object, dp);
+  }
+
+  // Stores the members of the JSON object in the struct.
+  // Unknown keys are ignored and missing ones leave the member unchanged.
+  // Returns false if the JSON is invalid, if the root isn't an object, or if
+  // a value doesn't fit in its member; the members read before the error keep
+  // their new value.
+  // The longest key or value must be shorter than TOKEN_CAPACITY, which by
+  // default is large enough for all the members.
+  template <size_t TOKEN_CAPACITY = base_type::TOKEN_CAPACITY>
+  bool parse(const char *json, TStruct &object,
+             uint8_t nestingLimit = 10) const {
+    Internals::SchemaReader<TStruct, base_type> reader(*this, object);
+    JsonStreamParser<TOKEN_CAPACITY> parser(reader, nestingLimit);
+    return parser.parse(json) && parser.finish() && reader.success();
+  }
+
+  template <size_t TOKEN_CAPACITY = base_type::TOKEN_CAPACITY>
+  bool parse(const char *json, size_t length, TStruct &object,
+             uint8_t nestingLimit = 10) const {
+    Internals::SchemaReader<TStruct, base_type> reader(*this, object);
+    JsonStreamParser<TOKEN_CAPACITY> parser(reader, nestingLimit);
+    return parser.parse(json, length) && parser.finish() && reader.success();
+  }
+};
+
+// Creates a JsonSchema from a list of jsonField().
+// All the fields must belong to the same struct.
+template <typename TStruct, typename... TMembers>
+constexpr JsonSchema<TStruct, TMembers...> makeJsonSchema(
+    JsonField<TStruct, TMembers>... fields) {
+  return JsonSchema<TStruct, TMembers...>(fields...);
+}
+}
+
+#endif
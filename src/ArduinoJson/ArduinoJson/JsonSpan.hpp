@@ -0,0 +1,225 @@
+// Copyright Benoit Blanchon 2014-2016
+// MIT License
+//
+// Arduino JSON library
+// https://github.com/bblanchon/ArduinoJson
+// If you like this project, please add a star!
+
+#pragma once
+
+#include "Internals/DynamicStringBuilder.hpp"
+#include "Internals/ParseRawValue.hpp"
+#include "Internals/RawJsonScanner.hpp"
+#include "Internals/StaticStringBuilder.hpp"
+#include "JsonArray.hpp"
+#include "JsonObject.hpp"
+#include "JsonVariant.hpp"
+#include "Print.hpp"
+#include "RawJson.hpp"
+
+#include <string.h>  // for strncmp, memcpy
+
+namespace ArduinoJson {
+
+// A value inside a JSON text, found without parsing the text.
+// Use it when you only need a few values of a document: nothing is allocated
+// and the parts of the document that are not on the path are skipped by
+// bracket matching.
+//
+//   JsonSpan message(json);
+//   JsonSpan result = message.get("/devicedrive/result");
+//   if (result.equals("SENT")) ...
+//
+// The text must be null-terminated and outlive the JsonSpan. Unlike
+// JsonBuffer::parseObject(), it isn't modified, and it isn't validated
+// either: the content of the skipped parts is not checked.
+class JsonSpan {
+ public:
+  // Creates an invalid span
+  JsonSpan() : _begin(NULL), _end(NULL) {}
+
+  // Creates a span over the value at the start of json
+  explicit JsonSpan(const char *json) {
+    _begin = json ? Internals::skipSpacesAndComments(json) : NULL;
+    _end = _begin ? Internals::RawJsonScanner::skipValue(_begin) : NULL;
+    if (!_end) _begin = NULL;
+  }
+
+  // Returns the value at the given JSON Pointer (RFC 6901), relative to this
+  // value, or an invalid span if there is no such value.
+  // For example "/status/connection_status" or "/upgrade/0".
+  // An empty pointer designates this value.
+  JsonSpan get(const char *pointer) const {
+    using namespace Internals;
+    if (!success() || !pointer) return JsonSpan();
+
+    const char *value = _begin;
+    while (*pointer == '/') {
+      const char *token = pointer + 1;
+      const char *tokenEnd = token;
+      while (*tokenEnd && *tokenEnd != '/') tokenEnd++;
+
+      if (*value == '[') {
+        size_t index;
+        if (!parseIndex(token, tokenEnd, &index)) return JsonSpan();
+        value = RawJsonScanner::findElement(value, index);
+      } else {
+        value = RawJsonScanner::findMember(value, token, tokenEnd);
+      }
+      if (!value) return JsonSpan();
+
+      pointer = tokenEnd;
+    }
+    if (*pointer) return JsonSpan();  // not a valid JSON Pointer
+
+    return JsonSpan(value);
+  }
+
+  // Returns the element at this position, or an invalid span if this isn't
+  // an array or if it is too short.
+  JsonSpan at(size_t index) const {
+    if (!success()) return JsonSpan();
+    const char *value = Internals::RawJsonScanner::findElement(_begin, index);
+    return value ? JsonSpan(value) : JsonSpan();
+  }
+
+  // Returns true if the span designates a value
+  bool success() const {
+    return _begin != NULL;
+  }
+
+  bool isArray() const {
+    return success() && *_begin == '[';
+  }
+
+  bool isObject() const {
+    return success() && *_begin == '{';
+  }
+
+  bool isString() const {
+    return success() && (*_begin == '\"' || *_begin == '\'');
+  }
+
+  // The text of the value, including the quotes of a string
+  const char *begin() const {
+    return _begin;
+  }
+
+  size_t size() const {
+    return static_cast<size_t>(_end - _begin);
+  }
+
+  // Returns the size of the JsonBuffer that parseObject(char*) or
+  // parseArray(char*) needs for this value, or 0 if it is invalid or nested
+  // deeper than nestingLimit.
+  // It is exact unless an object repeats a key. Add JSON_STRING_SIZE() of the
+  // whole input when it is parsed from a const char* or a String.
+  size_t capacity(uint8_t nestingLimit = 10) const {
+    if (!success()) return 0;
+    size_t capacity = 0;
+    if (!measure(_begin, &capacity, nestingLimit)) return 0;
+    return capacity;
+  }
+
+  // Compares the value with a string, without copying it.
+  // Strings are compared after the escape sequences are replaced, the other
+  // values are compared with their text (e.g. "true" or "42").
+  bool equals(const char *other) const {
+    if (!success() || !other) return false;
+    if (isString())
+      return Internals::RawJsonScanner::stringEquals(_begin, other);
+    return !strncmp(_begin, other, size()) && other[size()] == '\0';
+  }
+
+  // Converts the value to a JsonVariant.
+  // Since the text can't be modified, the value is copied in the buffer:
+  // the content of a string, or the text of the other values. Objects and
+  // arrays give a RawJson, numbers and booleans are converted.
+  // Returns an invalid variant if the value doesn't fit in size bytes.
+  JsonVariant toVariant(char *buffer, size_t size) const {
+    using namespace Internals;
+    if (!success()) return JsonVariant();
+
+    if (isString()) {
+      if (!RawJsonScanner::unescapeString(_begin, buffer, size))
+        return JsonVariant();
+      return JsonVariant(static_cast<const char *>(buffer));
+    }
+
+    if (this->size() >= size) return JsonVariant();
+    memcpy(buffer, _begin, this->size());
+    buffer[this->size()] = '\0';
+
+    if (isObject() || isArray()) return RawJson(buffer);
+    JsonVariant value = parseRawValue(buffer);
+    return value.success() ? value : JsonVariant(RawJson(buffer));
+  }
+
+  // Writes the text of the value, as it is in the document
+  size_t printTo(Print &print) const {
+    if (!success()) return 0;
+    return print.write(reinterpret_cast<const uint8_t *>(_begin), size());
+  }
+
+  size_t printTo(char *buffer, size_t bufferSize) const {
+    Internals::StaticStringBuilder sb(buffer, bufferSize);
+    return printTo(sb);
+  }
+
+  size_t printTo(String &str) const {
+    Internals::DynamicStringBuilder sb(str);
+    return printTo(sb);
+  }
+
+ private:
+  // Adds the size of the arrays, objects and nodes that JsonParser allocates
+  // for the value that starts at s, and returns the first character after it
+  static const char *measure(const char *s, size_t *capacity,
+                             uint8_t nestingLimit) {
+    using namespace Internals;
+    if (*s != '{' && *s != '[') return RawJsonScanner::skipValue(s);
+
+    bool isObject = *s == '{';
+    char closingChar = isObject ? '}' : ']';
+    *capacity += isObject ? JSON_OBJECT_SIZE(0) : JSON_ARRAY_SIZE(0);
+
+    s = skipSpacesAndComments(s + 1);
+    if (*s == closingChar) return s + 1;
+    for (;;) {
+      if (isObject) {
+        s = RawJsonScanner::skipValue(s);  // the key
+        if (!s) return NULL;
+        s = skipSpacesAndComments(s);
+        if (*s != ':') return NULL;
+        s = skipSpacesAndComments(s + 1);
+        *capacity += JSON_OBJECT_SIZE(1) - JSON_OBJECT_SIZE(0);
+      } else {
+        *capacity += JSON_ARRAY_SIZE(1) - JSON_ARRAY_SIZE(0);
+      }
+
+      // same limit as JsonParser::parseAnythingTo()
+      if (nestingLimit == 0) return NULL;
+      s = measure(s, capacity, static_cast<uint8_t>(nestingLimit - 1));
+      if (!s) return NULL;
+      s = skipSpacesAndComments(s);
+      if (*s == closingChar) return s + 1;
+      if (*s != ',') return NULL;
+      s = skipSpacesAndComments(s + 1);
+    }
+  }
+
+  // Array indexes are written in decimal, without leading zeros
+  static bool parseIndex(const char *s, const char *end, size_t *index) {
+    if (s == end || (*s == '0' && end - s > 1)) return false;
+    *index = 0;
+    for (; s < end; s++) {
+      if (*s < '0' || *s > '9') return false;
+      *index = *index * 10 + static_cast<size_t>(*s - '0');
+    }
+    return true;
+  }
+
+  const char *_begin;
+  const char *_end;
+};
+}
@@ -0,0 +1,36 @@
+// Copyright Benoit Blanchon 2014-2016
+// MIT License
+//
+// Arduino JSON library
+// https://github.com/bblanchon/ArduinoJson
+// If you like this project, please add a star!
+
+#pragma once
+
+#include "Internals/StreamParser.hpp"
+
+namespace ArduinoJson {
+
+// Parses JSON one character at a time and calls a JsonHandler for each
+// object, array, key and value, without building a tree in a JsonBuffer.
+// Only the current key or value is stored, so the template parameter
+// TOKEN_CAPACITY must be larger than the longest string or number expected,
+// including the terminator, unless setMaxTokenSize() lets the longer ones
+// move to the heap.
+// It accepts the same syntax as JsonBuffer::parseObject(), including quotes,
+// escape sequences and comments, but strings can't contain '\0'.
+template <size_t TOKEN_CAPACITY>
+class JsonStreamParser : public Internals::StreamParser {
+ public:
+  // nestingLimit is the number of levels of values, as for
+  // JsonBuffer::parseObject(): with 0, only an empty object or array is
+  // accepted, with 1 a flat one, and each level adds one.
+  // It can't be larger than MAX_NESTING_LIMIT.
+  explicit JsonStreamParser(JsonHandler &handler, uint8_t nestingLimit = 10)
+      : Internals::StreamParser(handler, _buffer, TOKEN_CAPACITY,
+                                nestingLimit) {}
+
+ private:
+  char _buffer[TOKEN_CAPACITY];
+};
+}
@@ -53,7 +53,7 @@ class JsonVariant : public JsonVariantBase<JsonVariant> {
 
   // Create a JsonVariant containing a floating point value.
   // The second argument specifies the number of decimal digits to write in
-  // the JSON string.
+  // the JSON string, up to FLOAT_MAX_DECIMALS.
   // JsonVariant(double value, uint8_t decimals);
   // JsonVariant(float value, uint8_t decimals);
   template <typename T>
@@ -61,10 +61,22 @@ class JsonVariant : public JsonVariantBase<JsonVariant> {
               typename TypeTraits::EnableIf<
                   TypeTraits::IsFloatingPoint<T>::value>::type * = 0) {
     using namespace Internals;
+    if (decimals > FLOAT_MAX_DECIMALS) decimals = FLOAT_MAX_DECIMALS;
     _type = static_cast<JsonVariantType>(JSON_FLOAT_0_DECIMALS + decimals);
     _content.asFloat = static_cast<JsonFloat>(value);
   }
 
+  // Create a JsonVariant containing a floating point value, written with as
+  // few digits as read back as the same value.
+  template <typename T>
+  JsonVariant(T value, Internals::ShortestFloat,
+              typename TypeTraits::EnableIf<
+                  TypeTraits::IsFloatingPoint<T>::value>::type * = 0) {
+    using namespace Internals;
+    _type = JSON_FLOAT_SHORTEST;
+    _content.asFloat = static_cast<JsonFloat>(value);
+  }
+
   // Create a JsonVariant containing an integer value.
   // JsonVariant(signed short)
   // JsonVariant(signed int)
@@ -252,6 +264,14 @@ class JsonVariant : public JsonVariantBase<JsonVariant> {
     return isString();
   }
   //
+  // bool is<RawJson>() const;
+  template <typename T>
+  typename TypeTraits::EnableIf<TypeTraits::IsSame<T, RawJson>::value,
+                                bool>::type
+  is() const {
+    return _type == Internals::JSON_UNPARSED;
+  }
+  //
   // bool is<JsonArray> const;
   // bool is<JsonArray&> const;
   // bool is<const JsonArray&> const;
@@ -288,6 +308,9 @@ class JsonVariant : public JsonVariantBase<JsonVariant> {
   // Serialize the variant to a JsonWriter
   void writeTo(Internals::JsonWriter &writer) const;
 
+  // Serialize the variant to a MsgPackWriter
+  void writeTo(Internals::MsgPackWriter &writer) const;
+
   // Value returned if the variant has an incompatible type
   template <typename T>
   static typename Internals::JsonVariantAs<T>::type defaultValue() {
@@ -343,6 +366,16 @@ inline JsonVariant double_with_n_digits(double value, uint8_t digits) {
   return JsonVariant(value, digits);
 }
 
+// The value will be written with as few digits as possible, while still
+// reading back as the same value.
+inline JsonVariant float_with_shortest_digits(float value) {
+  return JsonVariant(value, Internals::ShortestFloat());
+}
+
+inline JsonVariant double_with_shortest_digits(double value) {
+  return JsonVariant(value, Internals::ShortestFloat());
+}
+
 template <typename T>
 struct JsonVariant::IsConstructibleFrom {
   static const bool value =
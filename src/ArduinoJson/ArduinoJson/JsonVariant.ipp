@@ -10,6 +10,7 @@
 #include "Configuration.hpp"
 #include "JsonVariant.hpp"
 #include "Internals/Parse.hpp"
+#include "Internals/ParseRawValue.hpp"
 #include "JsonArray.hpp"
 #include "JsonObject.hpp"
 
@@ -171,6 +172,53 @@ inline void JsonVariant::writeTo(Internals::JsonWriter &writer) const {
   }
 }
 
+inline void JsonVariant::writeTo(Internals::MsgPackWriter &writer) const {
+  using namespace Internals;
+  switch (_type) {
+    case JSON_UNDEFINED:
+      writer.writeNull();
+      return;
+
+    case JSON_ARRAY:
+      _content.asArray->writeTo(writer);
+      return;
+
+    case JSON_OBJECT:
+      _content.asObject->writeTo(writer);
+      return;
+
+    case JSON_STRING:
+      writer.writeString(_content.asString);
+      return;
+
+    case JSON_UNPARSED: {
+      // numbers and booleans get their binary form, null is null, and the
+      // rest can only be kept as text
+      if (!_content.asString || !strcmp(_content.asString, "null"))
+        return writer.writeNull();
+      JsonVariant value = parseRawValue(_content.asString);
+      if (value.success()) return value.writeTo(writer);
+      writer.writeString(_content.asString);
+      return;
+    }
+
+    case JSON_NEGATIVE_INTEGER:
+      writer.writeInteger(_content.asInteger, true);
+      return;
+
+    case JSON_POSITIVE_INTEGER:
+      writer.writeInteger(_content.asInteger, false);
+      return;
+
+    case JSON_BOOLEAN:
+      writer.writeBoolean(_content.asInteger != 0);
+      return;
+
+    default:
+      writer.writeFloat(_content.asFloat);
+  }
+}
+
 #if ARDUINOJSON_ENABLE_STD_STREAM
 inline std::ostream &operator<<(std::ostream &os, const JsonVariant &source) {
   return source.printTo(os);
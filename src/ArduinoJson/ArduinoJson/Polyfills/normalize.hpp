@@ -13,17 +13,40 @@ namespace Polyfills {
 #ifdef ARDUINO
 
 // on embedded platform, favor code size over speed
+// but scale by binary powers of ten, so that a value like 1e-30 costs a handful
+// of soft-float operations instead of one per power of ten
 
 template <typename T>
 short normalize(T& value) {
+  static const T powers[] = {1e1, 1e2, 1e4, 1e8, 1e16};
+  // multiplying by powers[i] keeps the value below 10 iff it's below this
+  static const T thresholds[] = {1e0, 1e-1, 1e-3, 1e-7, 1e-15};
+
+  if (!value) return 0;
+
   short powersOf10 = 0;
-  while (value && value < 1) {
-    powersOf10--;
-    value *= 10;
-  }
-  while (value > 10) {
-    powersOf10++;
-    value /= 10;
+  if (value >= 10) {
+    while (value >= T(1e32)) {
+      value /= T(1e32);
+      powersOf10 += 32;
+    }
+    for (int i = 4; i >= 0; i--) {
+      if (value >= powers[i]) {
+        value /= powers[i];
+        powersOf10 += 1 << i;
+      }
+    }
+  } else if (value < 1) {
+    while (value < T(1e-31)) {
+      value *= T(1e32);
+      powersOf10 -= 32;
+    }
+    for (int i = 4; i >= 0; i--) {
+      if (value < thresholds[i]) {
+        value *= powers[i];
+        powersOf10 -= 1 << i;
+      }
+    }
   }
   return powersOf10;
 }
@@ -11,6 +11,7 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 namespace ArduinoJson {
 // This class reproduces Arduino's Print class
@@ -20,14 +21,21 @@ class Print {
 
   virtual size_t write(uint8_t) = 0;
 
-  size_t print(const char* s) {
+  // Writes a run of bytes in one call.
+  // Implementations should override this when they can do better than a
+  // virtual call per byte.
+  virtual size_t write(const uint8_t* buffer, size_t size) {
     size_t n = 0;
-    while (*s) {
-      n += write(*s++);
+    while (size--) {
+      n += write(*buffer++);
     }
     return n;
   }
 
+  size_t print(const char* s) {
+    return write(reinterpret_cast<const uint8_t*>(s), strlen(s));
+  }
+
   size_t println() { return write('\r') + write('\n'); }
 };
 }
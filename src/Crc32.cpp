@@ -0,0 +1,294 @@
+/*	Copyright 2016 DeviceDrive AS
+*
+*	Licensed under the Apache License, Version 2.0 (the "License");
+*	you may not use this file except in compliance with the License.
+*	You may obtain a copy of the License at
+*
+*	http ://www.apache.org/licenses/LICENSE-2.0
+*
+*	Unless required by applicable law or agreed to in writing, software
+*	distributed under the License is distributed on an "AS IS" BASIS,
+*	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*	See the License for the specific language governing permissions and
+*	limitations under the License.
+*
+*/
+
+#include "Crc32.h"
+#include <string.h>
+
+#if defined(__PCLMUL__) && defined(__SSE4_1__)
+#include <immintrin.h>
+#define CRC32_FOLDING 1
+#else
+#define CRC32_FOLDING 0
+#endif
+
+#define CRC32_POLYNOMIAL 0xedb88320
+
+// The tables are generated at compile time: table[k][i] is the CRC of byte i
+// followed by k zero bytes. Being const and constant-initialized, they are
+// placed in flash with the code.
+
+static constexpr uint32_t crcBits(uint32_t c, int bits)
+{
+	return bits == 0 ? c : crcBits((c & 1) ? (CRC32_POLYNOMIAL ^ (c >> 1)) : (c >> 1), bits - 1);
+}
+
+static constexpr uint32_t crcTableEntry(int slice, uint32_t i)
+{
+	return slice == 0 ? crcBits(i, 8)
+		: (crcTableEntry(slice - 1, i) >> 8) ^ crcBits(crcTableEntry(slice - 1, i) & 0xff, 8);
+}
+
+template <unsigned... I>
+struct CrcIndices {};
+
+template <unsigned N, unsigned... I>
+struct MakeCrcIndices : MakeCrcIndices<N - 1, N - 1, I...> {};
+
+template <unsigned... I>
+struct MakeCrcIndices<0, I...> {
+	typedef CrcIndices<I...> type;
+};
+
+template <typename TIndices>
+struct CrcTable;
+
+template <unsigned... I>
+struct CrcTable<CrcIndices<I...> > {
+	static const uint32_t values[CRC32_SLICES][256];
+};
+
+template <unsigned... I>
+const uint32_t CrcTable<CrcIndices<I...> >::values[CRC32_SLICES][256] = {
+	{ crcTableEntry(0, I)... },
+	{ crcTableEntry(1, I)... },
+	{ crcTableEntry(2, I)... },
+	{ crcTableEntry(3, I)... },
+#if CRC32_SLICES == 8
+	{ crcTableEntry(4, I)... },
+	{ crcTableEntry(5, I)... },
+	{ crcTableEntry(6, I)... },
+	{ crcTableEntry(7, I)... },
+#endif
+};
+
+static const uint32_t (&crc_table)[CRC32_SLICES][256] = CrcTable<MakeCrcIndices<256>::type>::values;
+
+// The polynomials x^(2^n) modulo the CRC polynomial, in the bit order of the
+// register (x^0 is the highest bit): multiplying a CRC by x^(8 * length)
+// appends length zero bytes to its data.
+
+static constexpr uint32_t crcMultiply(uint32_t a, uint32_t b, uint32_t bit, uint32_t product)
+{
+	return bit == 0 ? product
+		: crcMultiply(a, (b & 1) ? (b >> 1) ^ CRC32_POLYNOMIAL : b >> 1, bit >> 1, (a & bit) ? product ^ b : product);
+}
+
+static constexpr uint32_t crcSquare(uint32_t a)
+{
+	return crcMultiply(a, a, 1u << 31, 0);
+}
+
+static constexpr uint32_t crcPowerOfX(int n)
+{
+	return n == 0 ? 1u << 30 : crcSquare(crcPowerOfX(n - 1));
+}
+
+static const uint32_t crc_powers_of_x[] = {
+	crcPowerOfX(0), crcPowerOfX(1), crcPowerOfX(2), crcPowerOfX(3),
+	crcPowerOfX(4), crcPowerOfX(5), crcPowerOfX(6), crcPowerOfX(7),
+	crcPowerOfX(8), crcPowerOfX(9), crcPowerOfX(10), crcPowerOfX(11),
+	crcPowerOfX(12), crcPowerOfX(13), crcPowerOfX(14), crcPowerOfX(15),
+	crcPowerOfX(16), crcPowerOfX(17), crcPowerOfX(18), crcPowerOfX(19),
+	crcPowerOfX(20), crcPowerOfX(21), crcPowerOfX(22), crcPowerOfX(23),
+	crcPowerOfX(24), crcPowerOfX(25), crcPowerOfX(26), crcPowerOfX(27),
+	crcPowerOfX(28), crcPowerOfX(29), crcPowerOfX(30), crcPowerOfX(31)
+};
+
+Crc32::Crc32()
+{
+	begin();
+}
+
+void Crc32::begin()
+{
+	crc_register = INITIAL;
+	byte_count = 0;
+}
+
+void Crc32::update(const uint8_t *data, size_t size)
+{
+	crc_register = update(crc_register, data, size);
+	byte_count += size;
+}
+
+void Crc32::update(uint8_t data)
+{
+	crc_register = crc_table[0][(crc_register ^ data) & 0xff] ^ (crc_register >> 8);
+	byte_count++;
+}
+
+uint32_t Crc32::value() const
+{
+	return ~crc_register;
+}
+
+size_t Crc32::length() const
+{
+	return byte_count;
+}
+
+uint32_t Crc32::combine(uint32_t crc1, uint32_t crc2, size_t length2)
+{
+	// x^(8 * length2), from the bits of length2 * 8
+	uint32_t shift = 1u << 31;
+	for (int n = 3; length2 != 0; n++, length2 >>= 1) {
+		if (length2 & 1)
+			shift = multiplyModulo(crc_powers_of_x[n & 31], shift);
+	}
+	return multiplyModulo(shift, crc1) ^ crc2;
+}
+
+// a must not be 0
+uint32_t Crc32::multiplyModulo(uint32_t a, uint32_t b)
+{
+	uint32_t product = 0;
+	for (uint32_t bit = 1u << 31; ; bit >>= 1) {
+		if (a & bit) {
+			product ^= b;
+			if ((a & (bit - 1)) == 0)
+				break;
+		}
+		b = (b & 1) ? (b >> 1) ^ CRC32_POLYNOMIAL : b >> 1;
+	}
+	return product;
+}
+
+uint32_t Crc32::update(uint32_t crc, const uint8_t *data, size_t size)
+{
+#if CRC32_FOLDING
+	if (size >= 64) {
+		size_t folded = size & ~(size_t)15;
+		crc = updateFolded(crc, data, folded);
+		data += folded;
+		size -= folded;
+	}
+#endif
+	return updateSliced(crc, data, size);
+}
+
+uint32_t Crc32::updateBytes(uint32_t crc, const uint8_t *data, size_t size)
+{
+	while (size--)
+		crc = crc_table[0][(crc ^ *data++) & 0xff] ^ (crc >> 8);
+	return crc;
+}
+
+// Slicing-by-4 or 8: the register absorbs a whole word, and each of its bytes
+// is looked up in the table that accounts for the bytes that follow it.
+// The words are read as little-endian, so big-endian machines use the
+// byte loop.
+uint32_t Crc32::updateSliced(uint32_t crc, const uint8_t *data, size_t size)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	return updateBytes(crc, data, size);
+#else
+	// the Cortex-M0+ can't load unaligned words
+	size_t head = (4 - ((uintptr_t)data & 3)) & 3;
+	if (head > size)
+		head = size;
+	crc = updateBytes(crc, data, head);
+	data += head;
+	size -= head;
+
+	const uint32_t *words = (const uint32_t *)data;
+	while (size >= CRC32_SLICES) {
+		uint32_t low;
+		memcpy(&low, words++, 4);
+		low ^= crc;
+#if CRC32_SLICES == 8
+		uint32_t high;
+		memcpy(&high, words++, 4);
+		crc = crc_table[7][low & 0xff] ^ crc_table[6][(low >> 8) & 0xff]
+			^ crc_table[5][(low >> 16) & 0xff] ^ crc_table[4][low >> 24]
+			^ crc_table[3][high & 0xff] ^ crc_table[2][(high >> 8) & 0xff]
+			^ crc_table[1][(high >> 16) & 0xff] ^ crc_table[0][high >> 24];
+#else
+		crc = crc_table[3][low & 0xff] ^ crc_table[2][(low >> 8) & 0xff]
+			^ crc_table[1][(low >> 16) & 0xff] ^ crc_table[0][low >> 24];
+#endif
+		size -= CRC32_SLICES;
+	}
+	return updateBytes(crc, (const uint8_t *)words, size);
+#endif
+}
+
+#if CRC32_FOLDING
+
+// Folds 64 bytes per step with carry-less multiplications, then reduces the
+// 128-bit remainder with Barrett reduction, as described in Intel's "Fast CRC
+// Computation for Generic Polynomials Using PCLMULQDQ Instruction".
+// size must be a multiple of 16, and at least 64.
+static inline __m128i crcFold(__m128i x, __m128i constants, __m128i next)
+{
+	__m128i low = _mm_clmulepi64_si128(x, constants, 0x00);
+	__m128i high = _mm_clmulepi64_si128(x, constants, 0x11);
+	return _mm_xor_si128(_mm_xor_si128(low, high), next);
+}
+
+uint32_t Crc32::updateFolded(uint32_t crc, const uint8_t *data, size_t size)
+{
+	const __m128i k1k2 = _mm_set_epi64x(0x1c6e41596, 0x154442bd4);
+	const __m128i k3k4 = _mm_set_epi64x(0x0ccaa009e, 0x1751997d0);
+	const __m128i k5 = _mm_set_epi64x(0, 0x163cd6124);
+	const __m128i poly = _mm_set_epi64x(0x1f7011641, 0x1db710641);
+	const __m128i mask32 = _mm_set_epi32(0, 0, 0, -1);
+
+	__m128i x1 = _mm_loadu_si128((const __m128i *)data);
+	__m128i x2 = _mm_loadu_si128((const __m128i *)(data + 16));
+	__m128i x3 = _mm_loadu_si128((const __m128i *)(data + 32));
+	__m128i x4 = _mm_loadu_si128((const __m128i *)(data + 48));
+	x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)crc));
+	data += 64;
+	size -= 64;
+
+	while (size >= 64) {
+		x1 = crcFold(x1, k1k2, _mm_loadu_si128((const __m128i *)data));
+		x2 = crcFold(x2, k1k2, _mm_loadu_si128((const __m128i *)(data + 16)));
+		x3 = crcFold(x3, k1k2, _mm_loadu_si128((const __m128i *)(data + 32)));
+		x4 = crcFold(x4, k1k2, _mm_loadu_si128((const __m128i *)(data + 48)));
+		data += 64;
+		size -= 64;
+	}
+
+	x1 = crcFold(x1, k3k4, x2);
+	x1 = crcFold(x1, k3k4, x3);
+	x1 = crcFold(x1, k3k4, x4);
+	while (size >= 16) {
+		x1 = crcFold(x1, k3k4, _mm_loadu_si128((const __m128i *)data));
+		data += 16;
+		size -= 16;
+	}
+
+	// 128 to 64 bits
+	x1 = _mm_xor_si128(_mm_clmulepi64_si128(k3k4, x1, 0x01), _mm_srli_si128(x1, 8));
+
+	// 64 to 32 bits
+	x1 = _mm_xor_si128(_mm_clmulepi64_si128(_mm_and_si128(x1, mask32), k5, 0x00), _mm_srli_si128(x1, 4));
+
+	// Barrett reduction
+	__m128i t = _mm_clmulepi64_si128(_mm_and_si128(x1, mask32), poly, 0x10);
+	t = _mm_clmulepi64_si128(_mm_and_si128(t, mask32), poly, 0x00);
+	return (uint32_t)_mm_extract_epi32(_mm_xor_si128(t, x1), 1);
+}
+
+#else
+
+uint32_t Crc32::updateFolded(uint32_t crc, const uint8_t *data, size_t size)
+{
+	return updateSliced(crc, data, size);
+}
+
+#endif
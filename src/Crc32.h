@@ -0,0 +1,78 @@
+/*	Copyright 2016 DeviceDrive AS
+*
+*	Licensed under the Apache License, Version 2.0 (the "License");
+*	you may not use this file except in compliance with the License.
+*	You may obtain a copy of the License at
+*
+*	http ://www.apache.org/licenses/LICENSE-2.0
+*
+*	Unless required by applicable law or agreed to in writing, software
+*	distributed under the License is distributed on an "AS IS" BASIS,
+*	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*	See the License for the specific language governing permissions and
+*	limitations under the License.
+*
+*/
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// Number of tables of the slicing kernel: 8 reads 8 bytes per step from an
+// 8 KB table, 4 reads 4 bytes from a 4 KB table. The Cortex-M0+ of the
+// Arduino Zero has no cache and loads words as fast as bytes, so the larger
+// table only costs flash there.
+#ifndef CRC32_SLICES
+#if defined(__ARM_ARCH_6M__)
+#define CRC32_SLICES 4
+#else
+#define CRC32_SLICES 8
+#endif
+#endif
+
+// CRC-32 of zlib and Ethernet (reflected polynomial 0xEDB88320).
+// The tables are computed by the compiler and stay in flash.
+// On a computer with PCLMULQDQ (built with -mpclmul -msse4.1), long buffers
+// are folded 64 bytes at a time instead.
+//
+// Data that arrives in pieces is checked as it comes, without keeping it:
+//
+//	Crc32 crc;
+//	crc.update(chunk, chunk_size);	// for each chunk
+//	if (crc.value() == expected) ...
+//
+// Pieces checked separately, even out of order, are joined with combine().
+class Crc32
+{
+	public:
+		static const uint32_t INITIAL = 0xffffffff;
+
+		Crc32();
+
+		// Starts over, for a new piece of data
+		void begin();
+		void update(const uint8_t *data, size_t size);
+		void update(uint8_t data);
+
+		// The CRC-32 of the bytes since begin()
+		uint32_t value() const;
+		size_t length() const;
+
+		// Returns the CRC-32 of two adjacent pieces of data from the CRC-32 of
+		// each, and the length of the second, as zlib's crc32_combine().
+		static uint32_t combine(uint32_t crc1, uint32_t crc2, size_t length2);
+
+		// Continues the computation of crc over size bytes.
+		// crc is the register, before the final inversion: start with INITIAL
+		// and invert the result to get the standard CRC-32.
+		static uint32_t update(uint32_t crc, const uint8_t *data, size_t size);
+
+	private:
+		uint32_t crc_register;
+		size_t byte_count;
+
+		static uint32_t multiplyModulo(uint32_t a, uint32_t b);
+		static uint32_t updateBytes(uint32_t crc, const uint8_t *data, size_t size);
+		static uint32_t updateSliced(uint32_t crc, const uint8_t *data, size_t size);
+		static uint32_t updateFolded(uint32_t crc, const uint8_t *data, size_t size);
+};
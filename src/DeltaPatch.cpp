@@ -0,0 +1,220 @@
+/*	Copyright 2016 DeviceDrive AS
+*
+*	Licensed under the Apache License, Version 2.0 (the "License");
+*	you may not use this file except in compliance with the License.
+*	You may obtain a copy of the License at
+*
+*	http ://www.apache.org/licenses/LICENSE-2.0
+*
+*	Unless required by applicable law or agreed to in writing, software
+*	distributed under the License is distributed on an "AS IS" BASIS,
+*	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*	See the License for the specific language governing permissions and
+*	limitations under the License.
+*
+*/
+
+#include "DeltaPatch.h"
+#include <string.h>
+
+DeltaPatch::DeltaPatch()
+{
+	begin(NULL);
+}
+
+void DeltaPatch::begin(ImageStorage *source)
+{
+	this->source = source;
+	state = STATE_HEADER;
+	header_length = 0;
+	produced = 0;
+}
+
+size_t DeltaPatch::apply(const uint8_t *patch, size_t size, uint8_t *output, size_t output_size, size_t *output_length)
+{
+	size_t used = 0;
+	size_t length = 0;
+
+	while (state != STATE_FAILED) {
+		// a copy only needs room in the output
+		if (state == STATE_COPY) {
+			size_t count = output_size - length;
+			if (count > remaining)
+				count = remaining;
+			if (count == 0)
+				break;
+			if (!readSource(output + length, count))
+				break;
+			length += count;
+			produced += count;
+			remaining -= count;
+			if (remaining == 0)
+				endOperation();
+			continue;
+		}
+		if (used == size)
+			break;
+		if (state == STATE_DONE) {
+			// more operations than the new image needs
+			state = STATE_FAILED;
+			break;
+		}
+
+		switch (state) {
+			case STATE_HEADER:
+				header[header_length++] = patch[used++];
+				if (header_length < DELTA_HEADER_SIZE)
+					break;
+				if (headerWord(0) != DELTA_MAGIC) {
+					state = STATE_FAILED;
+					break;
+				}
+				endOperation();
+				*output_length = 0;
+				return used;
+
+			case STATE_OPCODE:
+				opcode = patch[used++];
+				if (opcode != DELTA_COPY && opcode != DELTA_ADD && opcode != DELTA_INSERT)
+					state = STATE_FAILED;
+				else {
+					state = opcode == DELTA_INSERT ? STATE_LENGTH : STATE_SOURCE;
+					number = 0;
+					number_shift = 0;
+				}
+				break;
+
+			case STATE_SOURCE:
+				if (readVarint(patch[used++])) {
+					source_offset = number;
+					state = STATE_LENGTH;
+					number = 0;
+					number_shift = 0;
+				}
+				break;
+
+			case STATE_LENGTH:
+				if (readVarint(patch[used++])) {
+					remaining = number;
+					startOperation();
+				}
+				break;
+
+			case STATE_DATA: {
+				size_t count = output_size - length;
+				if (count > remaining)
+					count = remaining;
+				if (count > size - used)
+					count = size - used;
+				if (count == 0) {
+					*output_length = length;
+					return used;
+				}
+				if (opcode == DELTA_ADD) {
+					if (!readSource(output + length, count))
+						break;
+					for (size_t i = 0; i < count; i++)
+						output[length + i] += patch[used + i];
+				}
+				else
+					memcpy(output + length, patch + used, count);
+				used += count;
+				length += count;
+				produced += count;
+				remaining -= count;
+				if (remaining == 0)
+					endOperation();
+				break;
+			}
+
+			default:
+				break;
+		}
+	}
+
+	*output_length = length;
+	return used;
+}
+
+bool DeltaPatch::hasHeader() const
+{
+	return state != STATE_HEADER && header_length == DELTA_HEADER_SIZE;
+}
+
+bool DeltaPatch::failed() const
+{
+	return state == STATE_FAILED;
+}
+
+bool DeltaPatch::finished() const
+{
+	return state == STATE_DONE;
+}
+
+uint32_t DeltaPatch::sourceSize() const
+{
+	return headerWord(1);
+}
+
+uint32_t DeltaPatch::sourceCrc() const
+{
+	return headerWord(2);
+}
+
+uint32_t DeltaPatch::targetSize() const
+{
+	return headerWord(3);
+}
+
+uint32_t DeltaPatch::targetCrc() const
+{
+	return headerWord(4);
+}
+
+uint32_t DeltaPatch::headerWord(int index) const
+{
+	const uint8_t *word = header + index * 4;
+	return word[0] | (word[1] << 8) | (word[2] << 16) | ((uint32_t)word[3] << 24);
+}
+
+// Returns true when the last byte of the number is read
+bool DeltaPatch::readVarint(uint8_t data)
+{
+	// the fifth byte only holds the 4 high bits, and ends the number
+	if (number_shift == 28 && (data & 0xf0) != 0) {
+		state = STATE_FAILED;
+		return false;
+	}
+	number |= (uint32_t)(data & 0x7f) << number_shift;
+	number_shift += 7;
+	return (data & 0x80) == 0;
+}
+
+// An operation can't write past the new image, nor read past the current one
+void DeltaPatch::startOperation()
+{
+	if (remaining > targetSize() - produced
+		|| (opcode != DELTA_INSERT && (source_offset > sourceSize() || remaining > sourceSize() - source_offset))) {
+		state = STATE_FAILED;
+		return;
+	}
+	if (remaining == 0)
+		endOperation();
+	else
+		state = opcode == DELTA_COPY ? STATE_COPY : STATE_DATA;
+}
+
+void DeltaPatch::endOperation()
+{
+	state = produced == targetSize() ? STATE_DONE : STATE_OPCODE;
+}
+
+bool DeltaPatch::readSource(uint8_t *output, size_t size)
+{
+	if (source == NULL || source->readCurrent(source_offset, output, size) != size) {
+		state = STATE_FAILED;
+		return false;
+	}
+	source_offset += size;
+	return true;
+}
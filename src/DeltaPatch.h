@@ -0,0 +1,97 @@
+/*	Copyright 2016 DeviceDrive AS
+*
+*	Licensed under the Apache License, Version 2.0 (the "License");
+*	you may not use this file except in compliance with the License.
+*	You may obtain a copy of the License at
+*
+*	http ://www.apache.org/licenses/LICENSE-2.0
+*
+*	Unless required by applicable law or agreed to in writing, software
+*	distributed under the License is distributed on an "AS IS" BASIS,
+*	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*	See the License for the specific language governing permissions and
+*	limitations under the License.
+*
+*/
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "ImageStorage.h"
+
+#define DELTA_MAGIC 0x44465257
+#define DELTA_HEADER_SIZE 20
+
+#define DELTA_COPY 0x01
+#define DELTA_ADD 0x02
+#define DELTA_INSERT 0x03
+
+// Applies a binary patch to the current image, as the patch arrives: the new
+// image is produced in a window given by the caller, so neither image is held
+// in memory.
+//
+// The patch starts with a header of five little-endian 32-bit words: the
+// magic "WRFD", the size and the CRC-32 of the image it applies to, then the
+// size and the CRC-32 of the new image. It is followed by operations, whose
+// numbers are unsigned LEB128 varints:
+//
+//	DELTA_COPY source length          copies length bytes of the current image
+//	DELTA_ADD source length bytes...  same, adding a byte to each (modulo 256)
+//	DELTA_INSERT length bytes...      inserts new bytes
+//
+// source is an offset in the current image. As in bsdiff, the changes of
+// recompiled code are mostly small differences, which compress well as ADD.
+class DeltaPatch
+{
+	public:
+		DeltaPatch();
+
+		// Starts a new patch, reading the current image from source
+		void begin(ImageStorage *source);
+
+		// Decodes the next bytes of the patch into output, and returns the number
+		// of bytes of the patch used: the rest must be given again. The number of
+		// bytes of the new image is set in output_length. Stops after the header,
+		// for the caller to check it. Once the patch is complete, call it with
+		// no patch until output_length is 0.
+		size_t apply(const uint8_t *patch, size_t size, uint8_t *output, size_t output_size, size_t *output_length);
+
+		bool hasHeader() const;
+		bool failed() const;
+		// All the bytes of the new image were produced
+		bool finished() const;
+
+		uint32_t sourceSize() const;
+		uint32_t sourceCrc() const;
+		uint32_t targetSize() const;
+		uint32_t targetCrc() const;
+
+	private:
+		enum State {
+			STATE_HEADER,
+			STATE_OPCODE,
+			STATE_SOURCE,
+			STATE_LENGTH,
+			STATE_COPY,
+			STATE_DATA,
+			STATE_DONE,
+			STATE_FAILED
+		};
+
+		ImageStorage *source;
+		State state;
+		uint8_t header[DELTA_HEADER_SIZE];
+		size_t header_length;
+		uint8_t opcode;
+		uint32_t number;
+		int number_shift;
+		uint32_t source_offset;
+		uint32_t remaining;
+		uint32_t produced;
+
+		uint32_t headerWord(int index) const;
+		bool readVarint(uint8_t data);
+		void startOperation();
+		void endOperation();
+		bool readSource(uint8_t *output, size_t size);
+};
@@ -0,0 +1,277 @@
+/*	Copyright 2016 DeviceDrive AS
+*
+*	Licensed under the Apache License, Version 2.0 (the "License");
+*	you may not use this file except in compliance with the License.
+*	You may obtain a copy of the License at
+*
+*	http ://www.apache.org/licenses/LICENSE-2.0
+*
+*	Unless required by applicable law or agreed to in writing, software
+*	distributed under the License is distributed on an "AS IS" BASIS,
+*	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*	See the License for the specific language governing permissions and
+*	limitations under the License.
+*
+*/
+
+#include <Arduino.h>
+#include "ImageStorage.h"
+
+#if defined(ARDUINO_ARCH_SAMD)
+
+FlashImageStorage::FlashImageStorage(uint32_t address, uint32_t state_address, uint32_t current_address)
+{
+	this->address = address;
+	this->state_address = state_address;
+	this->current_address = current_address;
+}
+
+bool FlashImageStorage::begin(size_t size, bool resume)
+{
+	if (address % NVMCTRL_ROW_SIZE != 0 || address + size > state_address)
+		return false;
+	written = 0;
+	row_erased = false;
+	page_length = 0;
+	// the page buffer is only written when it is full
+	NVMCTRL->CTRLB.bit.MANW = 1;
+	return true;
+}
+
+// A call starts at most one command: erasing a row or programming a page.
+// The next call returns 0 until it is done.
+// The chunks start on a row, so the rows of a chunk that is received again
+// are erased with it
+int FlashImageStorage::write(size_t offset, const uint8_t *data, size_t size)
+{
+	if (!isReady())
+		return 0;
+	if (hasFailed())
+		return -1;
+	if (offset != written + page_length) {
+		if (page_length > 0) {
+			memset(page + page_length, 0xff, FLASH_PAGE_SIZE - page_length);
+			writePage();
+			return 0;
+		}
+		written = offset;
+		row_erased = false;
+	}
+	if (written % NVMCTRL_ROW_SIZE == 0 && !row_erased) {
+		runCommand(NVMCTRL_CTRLA_CMD_ER, address + written);
+		row_erased = true;
+		return 0;
+	}
+
+	size_t count = FLASH_PAGE_SIZE - page_length;
+	if (count > size)
+		count = size;
+	memcpy(page + page_length, data, count);
+	page_length += count;
+	if (page_length == FLASH_PAGE_SIZE)
+		writePage();
+	return count;
+}
+
+bool FlashImageStorage::end()
+{
+	waitReady();
+	if (page_length > 0) {
+		if (written % NVMCTRL_ROW_SIZE == 0 && !row_erased) {
+			runCommand(NVMCTRL_CTRLA_CMD_ER, address + written);
+			waitReady();
+		}
+		memset(page + page_length, 0xff, FLASH_PAGE_SIZE - page_length);
+		writePage();
+		waitReady();
+	}
+	return !hasFailed();
+}
+
+// Only the pages that changed are programmed. The rows are erased first
+// when a bit has to go from 0 to 1, for a new image
+bool FlashImageStorage::saveState(const uint8_t *state, size_t size)
+{
+	if (size > FLASH_STATE_SIZE)
+		return false;
+	const uint8_t *saved = (const uint8_t *)state_address;
+	waitReady();
+
+	bool erase = false;
+	for (size_t i = 0; i < size && !erase; i++)
+		erase = (saved[i] & state[i]) != state[i];
+	if (erase) {
+		for (size_t row = 0; row < size; row += NVMCTRL_ROW_SIZE) {
+			runCommand(NVMCTRL_CTRLA_CMD_ER, state_address + row);
+			waitReady();
+		}
+	}
+
+	uint8_t state_page[FLASH_PAGE_SIZE];
+	for (size_t offset = 0; offset < size; offset += FLASH_PAGE_SIZE) {
+		size_t length = size - offset < FLASH_PAGE_SIZE ? size - offset : FLASH_PAGE_SIZE;
+		if (memcmp(saved + offset, state + offset, length) == 0)
+			continue;
+		memcpy(state_page, saved + offset, FLASH_PAGE_SIZE);
+		memcpy(state_page, state + offset, length);
+		programPage(state_address + offset, state_page);
+		waitReady();
+	}
+	return !hasFailed();
+}
+
+size_t FlashImageStorage::loadState(uint8_t *state, size_t size)
+{
+	if (size > FLASH_STATE_SIZE)
+		return 0;
+	waitReady();
+	memcpy(state, (const uint8_t *)state_address, size);
+	return size;
+}
+
+bool FlashImageStorage::isBusy()
+{
+	return !isReady();
+}
+
+bool FlashImageStorage::canReceiveWhileBusy()
+{
+	return false;
+}
+
+size_t FlashImageStorage::readCurrent(size_t offset, uint8_t *data, size_t size)
+{
+	if (offset > address - current_address)
+		return 0;
+	if (size > address - current_address - offset)
+		size = address - current_address - offset;
+	memcpy(data, (const uint8_t *)(current_address + offset), size);
+	return size;
+}
+
+bool FlashImageStorage::isReady()
+{
+	return NVMCTRL->INTFLAG.bit.READY;
+}
+
+// The status of the last command: a locked region, or a wrong address
+bool FlashImageStorage::hasFailed()
+{
+	return NVMCTRL->STATUS.reg & (NVMCTRL_STATUS_PROGE | NVMCTRL_STATUS_LOCKE | NVMCTRL_STATUS_NVME);
+}
+
+void FlashImageStorage::waitReady()
+{
+	while (!isReady());
+}
+
+void FlashImageStorage::writePage()
+{
+	programPage(address + written, page);
+	written += FLASH_PAGE_SIZE;
+	page_length = 0;
+	row_erased = written % NVMCTRL_ROW_SIZE != 0;
+}
+
+// Starts programming a page. The CPU waits on its next read of the flash
+void FlashImageStorage::programPage(uint32_t address, const uint8_t *data)
+{
+	runCommand(NVMCTRL_CTRLA_CMD_PBC, address);
+	waitReady();
+
+	// the page buffer is filled through the flash address space, in words
+	volatile uint32_t *destination = (volatile uint32_t *)address;
+	for (size_t i = 0; i < FLASH_PAGE_SIZE; i += 4) {
+		uint32_t word;
+		memcpy(&word, data + i, 4);
+		*destination++ = word;
+	}
+	runCommand(NVMCTRL_CTRLA_CMD_WP, address);
+}
+
+void FlashImageStorage::runCommand(uint32_t command, uint32_t address)
+{
+	NVMCTRL->STATUS.reg = NVMCTRL_STATUS_MASK;
+	NVMCTRL->ADDR.reg = address / 2;
+	NVMCTRL->CTRLA.reg = NVMCTRL_CTRLA_CMDEX_KEY | command;
+}
+
+#endif
+
+#if defined(__linux__)
+
+FileImageStorage::FileImageStorage(const char *path, const char *state_path, const char *current_path)
+{
+	this->path = path;
+	this->state_path = state_path;
+	this->current_path = current_path;
+}
+
+FileImageStorage::~FileImageStorage()
+{
+	if (file != NULL)
+		fclose(file);
+	if (current_file != NULL)
+		fclose(current_file);
+}
+
+bool FileImageStorage::begin(size_t size, bool resume)
+{
+	if (file != NULL)
+		fclose(file);
+	file = fopen(path, resume ? "r+b" : "wb");
+	return file != NULL;
+}
+
+int FileImageStorage::write(size_t offset, const uint8_t *data, size_t size)
+{
+	if (file == NULL || fseek(file, offset, SEEK_SET) != 0 || fwrite(data, 1, size, file) != size)
+		return -1;
+	return size;
+}
+
+bool FileImageStorage::end()
+{
+	if (file == NULL)
+		return false;
+	bool closed = fclose(file) == 0;
+	file = NULL;
+	return closed;
+}
+
+bool FileImageStorage::saveState(const uint8_t *state, size_t size)
+{
+	if (state_path == NULL)
+		return false;
+	FILE *state_file = fopen(state_path, "wb");
+	if (state_file == NULL)
+		return false;
+	bool written = fwrite(state, 1, size, state_file) == size;
+	return fclose(state_file) == 0 && written;
+}
+
+size_t FileImageStorage::loadState(uint8_t *state, size_t size)
+{
+	if (state_path == NULL)
+		return 0;
+	FILE *state_file = fopen(state_path, "rb");
+	if (state_file == NULL)
+		return 0;
+	size_t length = fread(state, 1, size, state_file);
+	fclose(state_file);
+	return length;
+}
+
+// The file stays open, since a patch reads it in many places
+size_t FileImageStorage::readCurrent(size_t offset, uint8_t *data, size_t size)
+{
+	if (current_path == NULL)
+		return 0;
+	if (current_file == NULL)
+		current_file = fopen(current_path, "rb");
+	if (current_file == NULL || fseek(current_file, offset, SEEK_SET) != 0)
+		return 0;
+	return fread(data, 1, size, current_file);
+}
+
+#endif
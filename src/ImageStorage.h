@@ -0,0 +1,150 @@
+/*	Copyright 2016 DeviceDrive AS
+*
+*	Licensed under the Apache License, Version 2.0 (the "License");
+*	you may not use this file except in compliance with the License.
+*	You may obtain a copy of the License at
+*
+*	http ://www.apache.org/licenses/LICENSE-2.0
+*
+*	Unless required by applicable law or agreed to in writing, software
+*	distributed under the License is distributed on an "AS IS" BASIS,
+*	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*	See the License for the specific language governing permissions and
+*	limitations under the License.
+*
+*/
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#if defined(ARDUINO_ARCH_SAMD)
+#include <Arduino.h>
+#endif
+#if defined(__linux__)
+#include <stdio.h>
+#endif
+
+// Where a client image received by WRF::startClientUpgrade() is written.
+// write() takes the bytes it can write right away, and is called again with
+// the rest. A storage that works on its own, like a DMA or a file system,
+// may let the next chunk arrive meanwhile. A storage that stops the CPU
+// while it works, like the internal flash, says so with
+// canReceiveWhileBusy(): the next chunk is then only requested once it is
+// idle, so no byte from the WRF is lost.
+//
+// A storage that keeps the state of the transfer lets an interrupted
+// upgrade resume: only the chunks that are missing are received again.
+class ImageStorage
+{
+	public:
+		virtual ~ImageStorage() {}
+
+		// Prepares for an image of size bytes. With resume, the chunks written
+		// before are kept. Returns false if the image can't fit, or can't be
+		// resumed
+		virtual bool begin(size_t size, bool resume) = 0;
+
+		// Writes the next bytes of the image at offset. The offsets increase,
+		// but skip the chunks that were received before. Returns the number of
+		// bytes taken, 0 while the storage is busy, or -1 on failure
+		virtual int write(size_t offset, const uint8_t *data, size_t size) = 0;
+
+		// Writes what is left
+		virtual bool end() = 0;
+
+		// Returns true while the storage still works on the last write
+		virtual bool isBusy() { return false; }
+
+		// Returns false if the serial port can't be read while the storage
+		// is busy
+		virtual bool canReceiveWhileBusy() { return true; }
+
+		// Keeps the state of the transfer, which survives a reset. Between two
+		// images, the state only changes bits from 1 to 0. Returns false if the
+		// state can't be kept: the transfer then starts over when interrupted
+		virtual bool saveState(const uint8_t *state, size_t size) { return false; }
+
+		// Returns the number of bytes of the state read
+		virtual size_t loadState(uint8_t *state, size_t size) { return 0; }
+
+		// Reads the image that runs now, to apply a delta patch to it.
+		// Returns the number of bytes read
+		virtual size_t readCurrent(size_t offset, uint8_t *data, size_t size) { return 0; }
+};
+
+#if defined(ARDUINO_ARCH_SAMD)
+
+#define FLASH_STATE_SIZE (8 * NVMCTRL_ROW_SIZE)
+#define FLASH_SKETCH_ADDRESS 0x2000
+
+// The image goes to the upper half of the internal flash by default, so the
+// sketch must fit in the lower half. The rows are erased as they are reached,
+// then the pages are programmed.
+// The SAMD21 can't read its flash while it erases or programs it: the CPU
+// and the interrupts wait for the instructions, for 6 ms per row erased and
+// 2.5 ms per page. The transfer pauses meanwhile.
+// The state of the transfer is kept in the last rows of the flash. Since its
+// bits only go from 1 to 0, it is mostly written without erasing.
+// The current image is the sketch, after the bootloader.
+// Copying the image over the sketch is left to the bootloader or the sketch.
+class FlashImageStorage : public ImageStorage
+{
+	public:
+		FlashImageStorage(uint32_t address = FLASH_SIZE / 2, uint32_t state_address = FLASH_SIZE - FLASH_STATE_SIZE,
+			uint32_t current_address = FLASH_SKETCH_ADDRESS);
+
+		virtual bool begin(size_t size, bool resume);
+		virtual int write(size_t offset, const uint8_t *data, size_t size);
+		virtual bool end();
+		virtual bool isBusy();
+		virtual bool canReceiveWhileBusy();
+		virtual bool saveState(const uint8_t *state, size_t size);
+		virtual size_t loadState(uint8_t *state, size_t size);
+		virtual size_t readCurrent(size_t offset, uint8_t *data, size_t size);
+
+	private:
+		uint32_t address;
+		uint32_t state_address;
+		uint32_t current_address;
+		size_t written = 0;
+		bool row_erased = false;
+		uint8_t page[FLASH_PAGE_SIZE];
+		size_t page_length = 0;
+
+		bool isReady();
+		bool hasFailed();
+		void waitReady();
+		void writePage();
+		void programPage(uint32_t address, const uint8_t *data);
+		void runCommand(uint32_t command, uint32_t address);
+};
+
+#endif
+
+#if defined(__linux__)
+
+// On a computer, the image is written to a file, and the state of the
+// transfer to another one if state_path is given. Delta patches apply to the
+// file at current_path
+class FileImageStorage : public ImageStorage
+{
+	public:
+		FileImageStorage(const char *path, const char *state_path = NULL, const char *current_path = NULL);
+		virtual ~FileImageStorage();
+
+		virtual bool begin(size_t size, bool resume);
+		virtual int write(size_t offset, const uint8_t *data, size_t size);
+		virtual bool end();
+		virtual bool saveState(const uint8_t *state, size_t size);
+		virtual size_t loadState(uint8_t *state, size_t size);
+		virtual size_t readCurrent(size_t offset, uint8_t *data, size_t size);
+
+	private:
+		const char *path;
+		const char *state_path;
+		const char *current_path;
+		FILE *file = NULL;
+		FILE *current_file = NULL;
+};
+
+#endif
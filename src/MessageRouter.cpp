@@ -0,0 +1,182 @@
+/*	Copyright 2016 DeviceDrive AS
+*
+*	Licensed under the Apache License, Version 2.0 (the "License");
+*	you may not use this file except in compliance with the License.
+*	You may obtain a copy of the License at
+*
+*	http ://www.apache.org/licenses/LICENSE-2.0
+*
+*	Unless required by applicable law or agreed to in writing, software
+*	distributed under the License is distributed on an "AS IS" BASIS,
+*	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*	See the License for the specific language governing permissions and
+*	limitations under the License.
+*
+*/
+
+#include "MessageRouter.h"
+
+#define DEVICEDRIVE_LOCAL "devicedrive"
+#define DEVICEDRIVE_REMOTE "DeviceDrive"
+#define CONFIGURATION "configuration"
+
+MessageRouter::MessageRouter()
+{
+	reset();
+}
+
+void MessageRouter::reset()
+{
+	mode = MODE_UNKNOWN;
+	depth = 0;
+	needs_comma = false;
+	skip_member = false;
+	interface_name = "";
+	interface_json = "";
+}
+
+bool MessageRouter::isRouting()
+{
+	return mode == MODE_INTERFACES;
+}
+
+void MessageRouter::onMessageReceived(WrfMessageReceivedCallback *message_received_cb)
+{
+	this->message_received_cb = message_received_cb;
+}
+
+void MessageRouter::onMessageStream(JsonHandler *stream_handler)
+{
+	this->stream_handler = stream_handler;
+}
+
+void MessageRouter::startObject()
+{
+	depth++;
+	if (!isRouting() || skip_member)
+		return;
+	if (depth < 2)
+		return;
+	if (stream_handler != NULL)
+		stream_handler->startObject();
+	beginToken();
+	appendText('{');
+}
+
+void MessageRouter::endObject()
+{
+	depth--;
+	if (!isRouting() || skip_member)
+		return;
+	if (depth < 1)
+		return;
+	if (stream_handler != NULL)
+		stream_handler->endObject();
+	appendText('}');
+	needs_comma = true;
+	if (depth == 1)
+		endInterfaceValue();
+}
+
+void MessageRouter::startArray()
+{
+	depth++;
+	if (!isRouting() || skip_member)
+		return;
+	if (depth < 2)
+		return;
+	if (stream_handler != NULL)
+		stream_handler->startArray();
+	beginToken();
+	appendText('[');
+}
+
+void MessageRouter::endArray()
+{
+	depth--;
+	if (!isRouting() || skip_member)
+		return;
+	if (depth < 1)
+		return;
+	if (stream_handler != NULL)
+		stream_handler->endArray();
+	appendText(']');
+	needs_comma = true;
+	if (depth == 1)
+		endInterfaceValue();
+}
+
+void MessageRouter::key(const char *key)
+{
+	// The first key tells who the message is for: the WRF doesn't mix
+	// module keys and interfaces in a message. A module key after an
+	// interface is skipped rather than routed as one
+	if (depth == 1 && mode == MODE_UNKNOWN)
+		mode = isModuleKey(key) ? MODE_MODULE : MODE_INTERFACES;
+
+	if (!isRouting())
+		return;
+
+	if (depth == 1) {
+		skip_member = isModuleKey(key);
+		if (skip_member)
+			return;
+		interface_name = key;
+		interface_json = "";
+		needs_comma = false;
+		if (stream_handler != NULL)
+			stream_handler->key(key);
+		return;
+	}
+	if (skip_member)
+		return;
+
+	if (stream_handler != NULL)
+		stream_handler->key(key);
+	beginToken();
+	if (message_received_cb != NULL)
+		JsonVariant(key).printTo(interface_json);
+	appendText(':');
+}
+
+void MessageRouter::value(const JsonVariant &value)
+{
+	if (!isRouting() || skip_member)
+		return;
+	if (depth < 1)
+		return;
+	if (stream_handler != NULL)
+		stream_handler->value(value);
+	beginToken();
+	if (message_received_cb != NULL)
+		value.printTo(interface_json);
+	needs_comma = true;
+	if (depth == 1)
+		endInterfaceValue();
+}
+
+bool MessageRouter::isModuleKey(const char *key)
+{
+	return !strcmp(key, DEVICEDRIVE_LOCAL) || !strcmp(key, DEVICEDRIVE_REMOTE) || !strcmp(key, CONFIGURATION);
+}
+
+void MessageRouter::beginToken()
+{
+	if (needs_comma)
+		appendText(',');
+	needs_comma = false;
+}
+
+// The text is only built when someone wants it
+void MessageRouter::appendText(char c)
+{
+	if (message_received_cb != NULL)
+		interface_json += c;
+}
+
+void MessageRouter::endInterfaceValue()
+{
+	if (message_received_cb != NULL)
+		message_received_cb(interface_name, interface_json);
+	interface_json = "";
+}
@@ -0,0 +1,69 @@
+/*	Copyright 2016 DeviceDrive AS
+*
+*	Licensed under the Apache License, Version 2.0 (the "License");
+*	you may not use this file except in compliance with the License.
+*	You may obtain a copy of the License at
+*
+*	http ://www.apache.org/licenses/LICENSE-2.0
+*
+*	Unless required by applicable law or agreed to in writing, software
+*	distributed under the License is distributed on an "AS IS" BASIS,
+*	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*	See the License for the specific language governing permissions and
+*	limitations under the License.
+*
+*/
+
+#pragma once
+#include <Arduino.h>
+#include "ArduinoJson/ArduinoJson.h"
+
+typedef void WrfMessageReceivedCallback(String interfaceName, String json_string);
+
+// Receives the events of the stream parser for one message from the WRF.
+// Messages for the module ("devicedrive", "DeviceDrive", "configuration")
+// are ignored: WRF reads them from their text. Messages for the interfaces
+// are routed while they are received, one interface at a time, so the whole
+// message never needs to be held in memory.
+// Which kind a message is, is told by its first key, so a message for the
+// module must start with a module key. The WRF never sends a message with
+// both; a module key that follows an interface is skipped.
+class MessageRouter : public JsonHandler
+{
+	public:
+		MessageRouter();
+		void reset();
+		bool isRouting();
+
+		void onMessageReceived(WrfMessageReceivedCallback *message_received_cb);
+		void onMessageStream(JsonHandler *stream_handler);
+
+		virtual void startObject();
+		virtual void endObject();
+		virtual void startArray();
+		virtual void endArray();
+		virtual void key(const char *key);
+		virtual void value(const JsonVariant &value);
+
+	private:
+		enum Mode {
+			MODE_UNKNOWN,
+			MODE_MODULE,
+			MODE_INTERFACES
+		};
+
+		WrfMessageReceivedCallback *message_received_cb = NULL;
+		JsonHandler *stream_handler = NULL;
+
+		Mode mode;
+		int depth;
+		bool needs_comma;
+		bool skip_member;
+		String interface_name;
+		String interface_json;
+
+		bool isModuleKey(const char *key);
+		void beginToken();
+		void appendText(char c);
+		void endInterfaceValue();
+};
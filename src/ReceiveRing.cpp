@@ -0,0 +1,253 @@
+/*	Copyright 2016 DeviceDrive AS
+*
+*	Licensed under the Apache License, Version 2.0 (the "License");
+*	you may not use this file except in compliance with the License.
+*	You may obtain a copy of the License at
+*
+*	http ://www.apache.org/licenses/LICENSE-2.0
+*
+*	Unless required by applicable law or agreed to in writing, software
+*	distributed under the License is distributed on an "AS IS" BASIS,
+*	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*	See the License for the specific language governing permissions and
+*	limitations under the License.
+*
+*/
+
+#include "ReceiveRing.h"
+#include "WRF.h"
+#include <string.h>
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+// The index written by the other side is read with acquire, and an index is
+// published with release once the data it covers is in place
+#define RING_LOAD(index) __atomic_load_n(&(index), __ATOMIC_ACQUIRE)
+#define RING_STORE(index, value) __atomic_store_n(&(index), (value), __ATOMIC_RELEASE)
+
+#if defined(ARDUINO_ARCH_SAMD)
+
+// The vector table must be aligned to its size, rounded up to a power of two
+static uint32_t ram_vectors[16 + PERIPH_COUNT_IRQn] __attribute__((aligned(256)));
+static ReceiveRing *interrupt_ring = NULL;
+static IRQn_Type interrupt_irq;
+static void (*interrupt_handler)();
+
+// The handler of the core fills the small buffer of the Uart first
+static void receiveInterrupt()
+{
+	interrupt_handler();
+	interrupt_ring->drain();
+}
+
+#endif
+
+ReceiveRing::ReceiveRing()
+{
+}
+
+ReceiveRing::~ReceiveRing()
+{
+#if defined(ARDUINO_ARCH_SAMD)
+	if (interrupt_ring == this) {
+		noInterrupts();
+		ram_vectors[16 + interrupt_irq] = (uint32_t)(uintptr_t)interrupt_handler;
+		interrupt_ring = NULL;
+		interrupts();
+	}
+#endif
+#if defined(__linux__)
+	if (thread_running) {
+		RING_STORE(thread_running, false);
+		pthread_join(thread, NULL);
+	}
+#endif
+	free(buffer);
+}
+
+bool ReceiveRing::begin(size_t size)
+{
+	if (buffer != NULL)
+		return false;
+	uint32_t ring_size = 1;
+	while (ring_size < size)
+		ring_size <<= 1;
+	buffer = (uint8_t *)malloc(ring_size);
+	if (buffer == NULL)
+		return false;
+	mask = ring_size - 1;
+	return true;
+}
+
+bool ReceiveRing::isActive()
+{
+	return serial != NULL;
+}
+
+#if defined(ARDUINO_ARCH_SAMD)
+
+bool ReceiveRing::attachInterrupt(HardwareSerial *serial, IRQn_Type irq)
+{
+	if (buffer == NULL || interrupt_ring != NULL)
+		return false;
+	this->serial = serial;
+
+	noInterrupts();
+	if (SCB->VTOR != (uint32_t)(uintptr_t)ram_vectors) {
+		memcpy(ram_vectors, (const void *)(uintptr_t)SCB->VTOR, sizeof(ram_vectors));
+		SCB->VTOR = (uint32_t)(uintptr_t)ram_vectors;
+		__DSB();
+	}
+	interrupt_irq = irq;
+	interrupt_handler = (void (*)())(uintptr_t)ram_vectors[16 + irq];
+	interrupt_ring = this;
+	ram_vectors[16 + irq] = (uint32_t)(uintptr_t)receiveInterrupt;
+	interrupts();
+	return true;
+}
+
+#endif
+
+#if defined(__linux__)
+
+bool ReceiveRing::startThread(HardwareSerial *serial)
+{
+	if (buffer == NULL || thread_running)
+		return false;
+	this->serial = serial;
+	thread_running = true;
+	if (pthread_create(&thread, NULL, threadMain, this) != 0) {
+		thread_running = false;
+		this->serial = NULL;
+		return false;
+	}
+	return true;
+}
+
+void *ReceiveRing::threadMain(void *ring)
+{
+	ReceiveRing *self = (ReceiveRing *)ring;
+	while (RING_LOAD(self->thread_running)) {
+		int data = self->serial->read();
+		if (data >= 0)
+			self->receive(data);
+		else
+			usleep(1000);
+	}
+	return NULL;
+}
+
+#endif
+
+void ReceiveRing::drain()
+{
+	while (serial->available() > 0)
+		receive(serial->read());
+}
+
+void ReceiveRing::receive(uint8_t data)
+{
+	// what came of the frame before discard() is dropped
+	uint32_t discard = RING_LOAD(discard_sequence);
+	if (discard != discard_served) {
+		discard_served = discard;
+		block_remaining = 0;
+		if (frame_received != 0)
+			markFrame(RECEIVE_FRAME_DISCARDED);
+	}
+
+	// an image chunk is raw bytes: its length ends it, not EOT
+	if (frame_received == 0 && data == SOH_CHAR) {
+		uint32_t sequence = RING_LOAD(block_sequence);
+		if (sequence != block_served) {
+			block_served = sequence;
+			block_remaining = block_length + 1;
+		}
+	}
+	frame_received++;
+
+	if (head - RING_LOAD(tail) <= mask) {
+		buffer[head & mask] = data;
+		RING_STORE(head, head + 1);
+	}
+	else {
+		frame_flags |= RECEIVE_FRAME_DAMAGED;
+		RING_STORE(lost, lost + 1);
+	}
+
+	if (block_remaining != 0) {
+		// STX ETX may be a restart of the WRF in the middle of the chunk, so
+		// what came is handed over: if it was data, the chunk goes on in the
+		// next frame
+		if (--block_remaining == 0 || (data == ETX_CHAR && last_data == STX_CHAR))
+			markFrame(0);
+	}
+	else if (data == EOT_CHAR || (data == ETX_CHAR && last_data == STX_CHAR))
+		markFrame(0);
+	last_data = data;
+}
+
+// Without a free mark, the frame is joined to the next one, and both are
+// dropped
+void ReceiveRing::markFrame(uint8_t flags)
+{
+	frame_received = 0;
+	flags |= frame_flags;
+	if (mark_head - RING_LOAD(mark_tail) >= RECEIVE_MARK_COUNT) {
+		frame_flags |= RECEIVE_FRAME_DAMAGED;
+		return;
+	}
+	Mark &mark = marks[mark_head % RECEIVE_MARK_COUNT];
+	mark.end = head;
+	mark.flags = flags;
+	frame_flags = 0;
+	RING_STORE(mark_head, mark_head + 1);
+}
+
+void ReceiveRing::expectBlock(size_t length)
+{
+	block_length = length;
+	RING_STORE(block_sequence, block_sequence + 1);
+}
+
+void ReceiveRing::discard()
+{
+	RING_STORE(discard_sequence, discard_sequence + 1);
+}
+
+bool ReceiveRing::frameAvailable()
+{
+	return mark_tail != RING_LOAD(mark_head);
+}
+
+uint32_t ReceiveRing::frameLength()
+{
+	return RING_LOAD(frame_received);
+}
+
+uint8_t ReceiveRing::frameFlags()
+{
+	return marks[mark_tail % RECEIVE_MARK_COUNT].flags;
+}
+
+int ReceiveRing::read()
+{
+	if (tail == marks[mark_tail % RECEIVE_MARK_COUNT].end)
+		return -1;
+	uint8_t data = buffer[tail & mask];
+	RING_STORE(tail, tail + 1);
+	return data;
+}
+
+void ReceiveRing::nextFrame()
+{
+	RING_STORE(tail, marks[mark_tail % RECEIVE_MARK_COUNT].end);
+	RING_STORE(mark_tail, mark_tail + 1);
+}
+
+uint32_t ReceiveRing::lostBytes()
+{
+	return RING_LOAD(lost);
+}
@@ -0,0 +1,120 @@
+/*	Copyright 2016 DeviceDrive AS
+*
+*	Licensed under the Apache License, Version 2.0 (the "License");
+*	you may not use this file except in compliance with the License.
+*	You may obtain a copy of the License at
+*
+*	http ://www.apache.org/licenses/LICENSE-2.0
+*
+*	Unless required by applicable law or agreed to in writing, software
+*	distributed under the License is distributed on an "AS IS" BASIS,
+*	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*	See the License for the specific language governing permissions and
+*	limitations under the License.
+*
+*/
+
+#pragma once
+#include <Arduino.h>
+#include <HardwareSerial.h>
+
+#if defined(__linux__)
+#include <pthread.h>
+#endif
+
+#ifndef RECEIVE_RING_SIZE
+#define RECEIVE_RING_SIZE 2048
+#endif
+#define RECEIVE_MARK_COUNT 16
+
+#define RECEIVE_FRAME_DAMAGED 0x01
+#define RECEIVE_FRAME_DISCARDED 0x02
+
+// A receive buffer filled from the serial interrupt, or from a thread on a
+// computer, while loop() is busy with something else.
+// The filling side marks the end of each frame from the WRF: EOT, STX ETX,
+// or the end of an image chunk announced by expectBlock(). The reading side
+// only sees complete frames.
+//
+// There is one writer and one reader, so no lock is needed: each index is
+// only written by its own side. A frame that didn't fit is marked as
+// damaged instead of being cut.
+class ReceiveRing
+{
+	public:
+		ReceiveRing();
+		~ReceiveRing();
+
+		// size is rounded up to a power of two
+		bool begin(size_t size);
+		bool isActive();
+
+#if defined(ARDUINO_ARCH_SAMD)
+		// Drains serial into the ring at the end of its SERCOM interrupt.
+		// The handler of the core is kept: the vector table is copied to
+		// RAM and the entry of irq is replaced.
+		bool attachInterrupt(HardwareSerial *serial, IRQn_Type irq);
+#endif
+#if defined(__linux__)
+		// Drains serial into the ring from a thread. Reading serial must be
+		// safe while the main thread writes to it.
+		bool startThread(HardwareSerial *serial);
+#endif
+
+		// Filling side
+		void receive(uint8_t data);
+		void drain();
+
+		// Reading side
+		// The next frame that starts with SOH has length more bytes
+		void expectBlock(size_t length);
+		// Drops what was received of the current frame
+		void discard();
+		bool frameAvailable();
+		// The bytes received of the frame that isn't complete yet
+		uint32_t frameLength();
+		// RECEIVE_FRAME_DAMAGED or RECEIVE_FRAME_DISCARDED, for the oldest frame
+		uint8_t frameFlags();
+		// The next byte of the oldest frame, -1 at its end
+		int read();
+		// Drops the rest of the oldest frame
+		void nextFrame();
+		uint32_t lostBytes();
+
+	private:
+		struct Mark {
+			uint32_t end;
+			uint8_t flags;
+		};
+
+		uint8_t *buffer = NULL;
+		uint32_t mask = 0;
+		HardwareSerial *serial = NULL;
+
+		// written by the filling side
+		uint32_t head = 0;
+		uint32_t mark_head = 0;
+		uint32_t lost = 0;
+		uint32_t frame_received = 0;
+		uint32_t block_remaining = 0;
+		uint32_t block_served = 0;
+		uint32_t discard_served = 0;
+		uint8_t frame_flags = 0;
+		uint8_t last_data = 0;
+		Mark marks[RECEIVE_MARK_COUNT];
+
+		// written by the reading side
+		uint32_t tail = 0;
+		uint32_t mark_tail = 0;
+		uint32_t block_length = 0;
+		uint32_t block_sequence = 0;
+		uint32_t discard_sequence = 0;
+
+#if defined(__linux__)
+		pthread_t thread;
+		bool thread_running = false;
+		static void *threadMain(void *ring);
+#endif
+
+		void markFrame(uint8_t flags);
+};
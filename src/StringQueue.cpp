@@ -96,6 +96,13 @@ String StringQueue::pop_front()
 		return "";
 }
 
+String StringQueue::at(int index)
+{
+	if (index < 0 || index >= item_count)
+		return "";
+	return list[(first_pos + index) % MAX_SIZE];
+}
+
 void StringQueue::increment(int & value)
 {
 	value++;
@@ -34,6 +34,8 @@ class StringQueue
 		String front();
 		String back();
 		String pop_front();
+		// The item index places after the front, "" past the back
+		String at(int index);
 
 
 	private:
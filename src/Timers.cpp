@@ -0,0 +1,61 @@
+/*	Copyright 2016 DeviceDrive AS
+*
+*	Licensed under the Apache License, Version 2.0 (the "License");
+*	you may not use this file except in compliance with the License.
+*	You may obtain a copy of the License at
+*
+*	http ://www.apache.org/licenses/LICENSE-2.0
+*
+*	Unless required by applicable law or agreed to in writing, software
+*	distributed under the License is distributed on an "AS IS" BASIS,
+*	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*	See the License for the specific language governing permissions and
+*	limitations under the License.
+*
+*/
+
+#include "Timers.h"
+
+Timers::Timers()
+{
+	running = 0;
+}
+
+void Timers::start(int timer, unsigned long now, unsigned long delay)
+{
+	deadlines[timer] = now + delay;
+	running |= 1 << timer;
+}
+
+void Timers::stop(int timer)
+{
+	running &= ~(1 << timer);
+}
+
+bool Timers::isRunning(int timer)
+{
+	return running & (1 << timer);
+}
+
+bool Timers::expire(int timer, unsigned long now)
+{
+	if (!isRunning(timer) || (long)(now - deadlines[timer]) < 0)
+		return false;
+	stop(timer);
+	return true;
+}
+
+unsigned long Timers::next(unsigned long now)
+{
+	unsigned long nearest = NO_DEADLINE;
+	for (int timer = 0; timer < TIMER_COUNT; timer++) {
+		if (!isRunning(timer))
+			continue;
+		long remaining = (long)(deadlines[timer] - now);
+		if (remaining <= 0)
+			return 0;
+		if ((unsigned long)remaining < nearest)
+			nearest = remaining;
+	}
+	return nearest;
+}
@@ -0,0 +1,51 @@
+/*	Copyright 2016 DeviceDrive AS
+*
+*	Licensed under the Apache License, Version 2.0 (the "License");
+*	you may not use this file except in compliance with the License.
+*	You may obtain a copy of the License at
+*
+*	http ://www.apache.org/licenses/LICENSE-2.0
+*
+*	Unless required by applicable law or agreed to in writing, software
+*	distributed under the License is distributed on an "AS IS" BASIS,
+*	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*	See the License for the specific language governing permissions and
+*	limitations under the License.
+*
+*/
+
+#pragma once
+#include <stdint.h>
+
+// The timers of the WRF class
+#define TIMER_POLL 0
+#define TIMER_LINKUP 1
+#define TIMER_RESPONSE 2
+#define TIMER_CHUNK 3
+#define TIMER_COUNT (TIMER_CHUNK + 1)
+
+#define NO_DEADLINE 0xffffffffUL
+
+// A few deadlines, in milliseconds from millis().
+// The times are compared through their difference, so that they stay right
+// when millis() wraps around, after 49 days. A delay must stay below 24 days.
+class Timers
+{
+	public:
+		Timers();
+
+		void start(int timer, unsigned long now, unsigned long delay);
+		void stop(int timer);
+		bool isRunning(int timer);
+
+		// Returns true once the deadline is reached, and stops the timer
+		bool expire(int timer, unsigned long now);
+
+		// The time until the nearest deadline, 0 if one is reached, or
+		// NO_DEADLINE if no timer runs
+		unsigned long next(unsigned long now);
+
+	private:
+		unsigned long deadlines[TIMER_COUNT];
+		uint8_t running;
+};
@@ -17,13 +17,12 @@
 #include <Arduino.h>
 #include "WRF.h"
 
-#define JSON_COMMAND_MAX_SIZE 512
-
 #define DEVICEDRIVE_LOCAL "devicedrive"
 #define DEVICEDRIVE_REMOTE "DeviceDrive"
 
 #define DEVICEDRIVE_ERROR "error"
 #define DEVICEDRIVE_UPGRADE "upgrade"
+#define DEVICEDRIVE_IMAGE "image"
 #define CONFIGURATION "configuration"
 #define DEVICEDRIVE_RESULT "result"
 #define DEVICEDRIVE_STATUS "status"
@@ -39,6 +38,7 @@
 #define ERROR_CODE "ErrorCode"
 #define ERROR_INVALID_TOKEN "INVALID_TOKEN"
 #define ERROR_SYSTEM_BUSY "SYSTEM_BUSY" 
+#define ERROR_INVALID_CRC "INVALID_CRC"
 #define ERROR_MSG_QUEUE_FULL "Message queue is full"
 #define ERROR_UPGRADE "UPGRADE_ERROR"
 
@@ -48,24 +48,38 @@
 #define COMMAND_SETUP "setup"
 #define COMMAND_CHECK_UPGRADE "check_upgrade"
 #define COMMAND_GET_UPGRADE "get_upgrade"
+#define COMMAND_GET_IMAGE "get_image"
 #define COMMAND_INTROSPECT "introspect"
 
 #define PARAM_VISIBILITY "visibility"
 #define PARAM_SILENT_CONNECT "silent_connect"
 
-#define PLOYNOMIAL 0xedb88320
-#define BUFSIZE     512
-#define CRC_BLOCK_SIZE 512
+// The state of an image transfer, saved by the ImageStorage, is followed by
+// the bitmap of the missing chunks and by the CRC-32 of each chunk
+typedef struct {
+	uint32_t magic;
+	uint32_t size;
+	uint32_t crc;
+	uint32_t chunk_size;
+} WrfImageState;
+
+#define IMAGE_STATE_MAGIC 0x57524649
+#define IMAGE_BITMAP_SIZE(chunks) ((((chunks) + 31) / 32) * 4)
 
-WRF::WRF(HardwareSerial *serial, String version, String productKey, String introspect, HardwareSerial *log_port /*=NULL*/, int pollInterval) {
+WRF::WRF(HardwareSerial *serial, String version, String productKey, String introspect, HardwareSerial *log_port /*=NULL*/, int pollInterval)
+	: stream_parser(message_router) {
 	this->product_key = productKey;
 	this->serial = serial;
     this->version = version;
     this->baud_rate = 115200;
-    this->introspect = introspect;
+    this->introspect = minify(introspect);
     this->log_port = log_port;
 	this->pollInterval = pollInterval;
+	this->max_poll_interval = pollInterval;
+	this->current_poll_interval = pollInterval;
 	this->message_queue = StringQueue();
+	this->module_text[0] = '\0';
+	stream_parser.setMaxTokenSize(max_message_size);
 }
 
 void WRF::setup(WRFConfig &config) {
@@ -75,15 +89,22 @@ void WRF::setup(WRFConfig &config) {
 	send(command);
 }
 
-void WRF::loopHandler()
+// Returns the time in milliseconds until the library needs loopHandler()
+// again, unless the WRF sends something before: the sketch may sleep or do
+// other work until then, as long as it checks the serial port
+unsigned long WRF::loopHandler()
 {
 	this->current_time = millis();
 	handleSerialInput();
+	handleImageStorage();
 	handleLinkupTimeout();
+	handleResponseTimeout();
+	handleChunkTimeout();
 	handleAutomaticPoll();
 
 	handleMessageQueue();
 
+	return nextDeadline();
 }
 
 void WRF::setupParam(String param, String value)
@@ -104,7 +125,7 @@ void WRF::prepareLinkupMode(int vivibility_seconds)
 {
 	is_connected = false;
 	awaiting_linkup = true;
-	linkup_timeout = current_time + ((vivibility_seconds +1) * 1000);
+	timers.start(TIMER_LINKUP, millis(), (vivibility_seconds + 1) * 1000UL);
 
 	Dictionary params = {
 		{ PARAM_SILENT_CONNECT, "1" },
@@ -124,19 +145,82 @@ void WRF::poll() {
 	}
 }
 
+// A poll is only sent when no message was sent for the whole interval: the
+// reply to any message brings the messages from the cloud as well. For the
+// same reason, no poll is sent while a message waits in the queue, and the
+// interval stays the same. Each poll that finds the link idle doubles the
+// interval, up to max_poll_interval
 void WRF::automaticPoll()
 {
-	if (current_time - previous_time >= pollInterval) {
-		previous_time = current_time;
+	if (timers.expire(TIMER_POLL, current_time)) {
+		if (hasQueuedMessage()) {
+			timers.start(TIMER_POLL, current_time, current_poll_interval);
+			return;
+		}
+		current_poll_interval *= 2;
+		if (current_poll_interval > max_poll_interval)
+			current_poll_interval = max_poll_interval;
+		timers.start(TIMER_POLL, current_time, current_poll_interval);
 		poll();
 	}
 }
 
-void WRF::setPollInterval(int seconds)
+// With max_seconds, the interval grows while nothing comes from the cloud,
+// and goes back to seconds when a message comes
+void WRF::setPollInterval(int seconds, int max_seconds)
 {
 	this->pollInterval = seconds* 1000;
+	this->max_poll_interval = max_seconds > seconds ? max_seconds * 1000UL : pollInterval;
+	this->current_poll_interval = pollInterval;
+	if (pollInterval != 0)
+		timers.start(TIMER_POLL, millis(), pollInterval);
+	else
+		timers.stop(TIMER_POLL);
+}
+
+void WRF::restartPollTimer()
+{
+	if (pollInterval != 0)
+		timers.start(TIMER_POLL, millis(), current_poll_interval);
+}
+
+// How long a command waits for its answer before it is sent again, a few
+// times. 0 waits forever
+void WRF::setResponseTimeout(unsigned long timeout_millis)
+{
+	response_timeout = timeout_millis;
+	if (response_timeout == 0)
+		timers.stop(TIMER_RESPONSE);
+}
+
+#if defined(ARDUINO_ARCH_SAMD)
+
+// Receives into a ring of size bytes from the interrupt of the SERCOM of the
+// serial port, e.g. SERCOM0_IRQn for Serial1 on the Arduino Zero
+bool WRF::useReceiveInterrupt(IRQn_Type irq, size_t size)
+{
+	if (!receive_ring.begin(size) || !receive_ring.attachInterrupt(serial, irq)) {
+		handleErrorMsg("Unable to use the receive interrupt");
+		return false;
+	}
+	return true;
 }
 
+#endif
+
+#if defined(__linux__)
+
+bool WRF::useReceiveThread(size_t size)
+{
+	if (!receive_ring.begin(size) || !receive_ring.startThread(serial)) {
+		handleErrorMsg("Unable to start the receive thread");
+		return false;
+	}
+	return true;
+}
+
+#endif
+
 void WRF::checkPendingUpgrades()
 {
 	sendCommandWithoutParams(COMMAND_CHECK_UPGRADE);
@@ -151,8 +235,17 @@ void WRF::startWrfUpgrade()
 	sendCommand(COMMAND_GET_UPGRADE, params);
 }
 
+// With PROTOCOL_CHUNKED, the WRF doesn't flash the client itself: the image
+// is received by this library, into the storage of setImageStorage().
+// PROTOCOL_DELTA is the same, but the WRF may send a patch to the current
+// image instead of the image
 void WRF::startClientUpgrade(int file_no, String protocol, int delay_millis, String toggle_pattern)
 {
+	bool chunked = protocol == PROTOCOL_CHUNKED || protocol == PROTOCOL_DELTA;
+	if (chunked && image_storage == NULL) {
+		handleErrorMsg("No image storage");
+		return;
+	}
 	Dictionary params = {
 		{ "module", "CLIENT" },
 		{ "protocol", protocol },
@@ -163,9 +256,16 @@ void WRF::startClientUpgrade(int file_no, String protocol, int delay_millis, Str
 		addToDictionary(params, "delay", String(delay_millis));
 	if (toggle_pattern != DEFAULT_TOGGLE)
 		addToDictionary(params, "pin_toggle", toggle_pattern);
+	if (chunked)
+		addToDictionary(params, "chunk_size", String(IMAGE_CHUNK_SIZE));
 	sendCommand(COMMAND_GET_UPGRADE, params);
 }
 
+void WRF::setImageStorage(ImageStorage *image_storage)
+{
+	this->image_storage = image_storage;
+}
+
 void WRF::send(String raw_string) {
 	bool message_pushed = message_queue.push_back(raw_string);
 	handleMessageQueue();
@@ -219,6 +319,7 @@ void WRF::sendCommand(String command, Dictionary params)
 
 	String send_string;
 	root.printTo(send_string);
+	recordCommandMemory(jsonBuffer);
     send(send_string);
 }
 
@@ -231,11 +332,29 @@ void WRF::sendCommand(String command, String param)
 
 	StaticJsonBuffer<JSON_COMMAND_MAX_SIZE> buffer;
 	param = "{" + param + "}";
-	JsonObject& introspect_object = buffer.parseObject(param);
-	merge(json_command, introspect_object);
+	JsonParseError error;
+	JsonObject *param_object = &buffer.parseObject(param, error);
+
+	// Large parameters, like a long introspect document, are parsed again in
+	// a buffer of the exact size, on the heap
+	size_t large_size = 0;
+	if (error.noMemory())
+		large_size = JsonSpan(param.c_str()).capacity() + JSON_STRING_SIZE(param.length());
+	if (large_size > max_message_size) {
+		handleErrorMsg("Command too large: " + command);
+		return;
+	}
+	DynamicJsonBuffer large_buffer(large_size);
+	if (large_size > 0)
+		param_object = &large_buffer.parseObject(param, error);
+	if (!error.success())
+		log_message("Invalid parameters: " + String(error.c_str()) + " at " + String(error.offset()));
+	merge(json_command, *param_object);
 
 	String send_string;
 	root.printTo(send_string);
+	recordCommandMemory(jsonBuffer);
+	recordCommandMemory(buffer);
 	send(send_string);
 }
 
@@ -287,6 +406,12 @@ void WRF::overrideOnStart(WrfStartUpCallback * start_cb)
 void WRF::onMessageReceived(WrfMessageReceivedCallback * message_received_cb)
 {
 	this->message_received_cb = message_received_cb;
+	message_router.onMessageReceived(message_received_cb);
+}
+
+void WRF::onMessageStream(JsonHandler * stream_handler)
+{
+	message_router.onMessageStream(stream_handler);
 }
 
 void WRF::onPendingUpgrades(WrfUpgradeCallback * pending_upgrades_cb)
@@ -304,12 +429,35 @@ void WRF::onStatusReceived(WrfMessageReceivedCallback * status_received_cb)
 	this->status_received_cb = status_received_cb;
 }
 
+void WRF::onImageReceived(WrfCallback * image_received_cb)
+{
+	this->image_received_cb = image_received_cb;
+}
+
 void WRF::clearMessageQueue()
 {
 	awaiting_response = false;
 	message_queue.clear();
 }
 
+// The messages longer than MODULE_TEXT_SIZE are kept on the heap, up to this
+// size. It also limits the parameters of sendCommand().
+void WRF::setMaxMessageSize(size_t size)
+{
+	max_message_size = size;
+	stream_parser.setMaxTokenSize(size);
+}
+
+WrfMemoryStats WRF::getMemoryStats()
+{
+	return memory_stats;
+}
+
+void WRF::resetMemoryStats()
+{
+	memory_stats = WrfMemoryStats();
+}
+
 int WRF::getListSize(List &list)
 {
 	int i = 0;
@@ -369,18 +517,20 @@ void WRF::handleErrorMsg(String error_msg)
 		error_cb(error_msg);
 }
 
-void WRF::handleStatusMsg(JsonObject& status_obj)
+void WRF::handleStatusMsg(const JsonSpan &status)
 {
 	bool previous_online_status = isOnline();
 
-	if (status_obj.containsKey(STATUS_CONNECTION_STATUS)) {
-		if (String(status_obj[STATUS_CONNECTION_STATUS].asString()) == STATUS_GOT_IP)
+	JsonSpan connection_status = status.get("/" STATUS_CONNECTION_STATUS);
+	if (connection_status.success()) {
+		if (connection_status.equals(STATUS_GOT_IP))
 			is_connected = true;
-		else if (String(status_obj[STATUS_CONNECTION_STATUS].asString()) != STATUS_CONNECTING)
+		else if (!connection_status.equals(STATUS_CONNECTING))
 			is_connected = false;
 	}
-	if (status_obj.containsKey(STATUS_LOCAL_VISISBILITY)) {
-		if (String(status_obj[STATUS_LOCAL_VISISBILITY].asString()) == STATUS_ON) 
+	JsonSpan local_visibility = status.get("/" STATUS_LOCAL_VISISBILITY);
+	if (local_visibility.success()) {
+		if (local_visibility.equals(STATUS_ON)) 
 			is_visible = true;
 		else
 			is_visible = false;
@@ -393,27 +543,32 @@ void WRF::handleStatusMsg(JsonObject& status_obj)
 		not_connected_cb();
 	}
 
-	if (awaiting_linkup && !is_visible)
+	if (awaiting_linkup && !is_visible) {
 		awaiting_linkup = is_visible;
+		timers.stop(TIMER_LINKUP);
+	}
 
 	if (status_received_cb != NULL) {
 		String status_string;
-		status_obj.printTo(status_string);
+		status.printTo(status_string);
 		status_received_cb(DEVICEDRIVE_STATUS, status_string);
 	}
 }
 
+// The interval of the constructor starts with the first loop
 void WRF::handleAutomaticPoll()
 {
 	if (pollInterval != 0)
 	{
+		if (!timers.isRunning(TIMER_POLL))
+			timers.start(TIMER_POLL, current_time, current_poll_interval);
 		automaticPoll();
 	}
 }
 
 void WRF::handleLinkupTimeout()
 {
-	if (awaiting_linkup && current_time > linkup_timeout) {
+	if (awaiting_linkup && timers.expire(TIMER_LINKUP, current_time)) {
 		awaiting_linkup = false;
 		if (!isOnline()) {
 			getStatus();
@@ -421,7 +576,96 @@ void WRF::handleLinkupTimeout()
 	}
 }
 
-void WRF::handleConfiguration(JsonObject &configuration)
+// A command that isn't answered is sent again, as if its answer was damaged
+void WRF::handleResponseTimeout()
+{
+	if (!awaiting_response) {
+		timers.stop(TIMER_RESPONSE);
+		return;
+	}
+	if (!timers.expire(TIMER_RESPONSE, current_time))
+		return;
+
+	log_message("No response from WRF");
+	resetReceivedMessage();
+	receive_ring.discard();
+	image_chunk_receiving = false;
+	image_fill_length = 0;
+	image_trailer_length = 0;
+	awaiting_response = false;
+	if (frame_retries < FRAME_RETRY_LIMIT) {
+		frame_retries++;
+		return;
+	}
+
+	String request = message_queue.pop_front();
+	frame_retries = 0;
+	handleErrorMsg("No response from WRF");
+	if (isImageRequest(request))
+		abortImage("Image transfer failed");
+}
+
+// A chunk ends after its length, so a chunk that lost a byte would be waited
+// for forever, even without the response timeout: once it stops growing for
+// IMAGE_BYTE_TIMEOUT, what came of it is dropped and it is requested again.
+// EOT and STX ETX can be bytes of the chunk, so they don't end it by
+// themselves, but the chunk stalls after them when they were the end of a
+// frame
+void WRF::handleChunkTimeout()
+{
+	size_t received = receivedChunkLength();
+	if (received == 0) {
+		timers.stop(TIMER_CHUNK);
+		image_chunk_progress = 0;
+		return;
+	}
+	if (received != image_chunk_progress) {
+		image_chunk_progress = received;
+		timers.start(TIMER_CHUNK, current_time, IMAGE_BYTE_TIMEOUT);
+		return;
+	}
+	if (!timers.expire(TIMER_CHUNK, current_time))
+		return;
+
+	log_message("Image chunk stalled: " + String(image_chunk));
+	image_chunk_progress = 0;
+	receive_ring.discard();
+	image_chunk_receiving = false;
+	if (image_chunk_restart)
+		handleRestart();
+	else
+		retryImageChunk("Image transfer failed");
+}
+
+// The bytes of the requested chunk received so far. With the receive ring,
+// they stay in the ring until the chunk is complete
+size_t WRF::receivedChunkLength()
+{
+	if (!image_chunk_requested)
+		return 0;
+	size_t length = image_chunk_receiving ? 1 + image_fill_length + image_trailer_length : 0;
+	if (receive_ring.isActive())
+		length += receive_ring.frameLength();
+	return length;
+}
+
+// Received bytes, a command to send or a chunk to store need the next loop
+unsigned long WRF::nextDeadline()
+{
+	if (serial->available() > 0 || (!message_queue.empty() && canSendCommand()))
+		return 0;
+	if (receive_ring.frameAvailable())
+		return 0;
+	if (image_buffer != NULL && image_half_length[image_flush_half] != 0)
+		return 0;
+	if (image_buffer != NULL && image_delta && image_missing == 0)
+		return 0;
+	if (image_buffer != NULL && !image_chunk_requested && image_storage->isBusy())
+		return 0;
+	return timers.next(current_time);
+}
+
+void WRF::handleConfiguration(const JsonSpan &configuration)
 {
 	// Need to check if AP is off to be sure we kan send messages. 
 	getStatus();
@@ -437,8 +681,16 @@ void WRF::triggerSentMessage()
 void WRF::handleMessageQueue()
 {
 	if (!message_queue.empty() && canSendCommand()) {
-		serial->print(message_queue.front() + EOT_CHAR);
+		// the chunk is raw bytes: the receive ring needs its length to tell
+		// where it ends
+		if (image_chunk_requested && isImageRequest(message_queue.front()))
+			receive_ring.expectBlock(image_chunk_length + FRAME_CRC_DIGITS);
+		serial->print(appendFrameCrc(message_queue.front()) + EOT_CHAR);
 		awaiting_response = true;
+		if (response_timeout != 0)
+			timers.start(TIMER_RESPONSE, millis(), response_timeout);
+		if (!isCommand(message_queue.front()))
+			restartPollTimer();
 	}
 }
 
@@ -461,152 +713,894 @@ void WRF::handleStartup(WRFConfig & config)
 	connect();
 }
 
-void WRF::handleResultMsg(String result)
+void WRF::handleResultMsg(const JsonSpan &result)
 {
-    if (result == RESULT_SENT)
+    if (result.equals(RESULT_SENT))
         triggerSentMessage();
 }
 
-void WRF::handleReceivedMessage(JsonObject &message_obj)
-{
-    if (message_received_cb == NULL)
-        return;
-
-    for (JsonObject::iterator it = message_obj.begin(); it != message_obj.end(); ++it)
-    {
-        String interface_name = it->key;
-        JsonObject &data = message_obj[interface_name].asObject();
-        String json_string;
-        data.printTo(json_string);
-        message_received_cb(interface_name, json_string);
-    }
-
-}
-
-
-void WRF::handleUpgradeMsg(JsonArray &pending_upgrades)
+void WRF::handleUpgradeMsg(const JsonSpan &pending_upgrades)
 {
     if (pending_upgrades_cb == NULL)
         return;
     List list;
-    for (JsonArray::iterator it = pending_upgrades.begin(); it != pending_upgrades.end(); ++it)
-        addToList(list, *it);
+    char item[STREAM_TOKEN_SIZE];
+    for (int i = 0; i < MAX_LIST_SIZE; i++)
+    {
+        JsonVariant value = pending_upgrades.at(i).toVariant(item, sizeof(item));
+        if (!value.success())
+            break;
+        addToList(list, value.as<String>());
+    }
     if (getListSize(list) > 0)
         pending_upgrades_cb(list);
 }
 
 
-void WRF::handleWrfMessage(String &msg)
+// Module messages are only read in a few places, so they are queried in
+// their text rather than parsed. This is the longest step of loopHandler():
+// each get() scans its span, 3 times the message and 5 times the
+// devicedrive member, then the member that is handled is scanned again, so
+// the cost is about 10 passes over up to max_message_size bytes, without
+// allocating anything
+void WRF::handleWrfMessage(const JsonSpan &message)
 {
-    log_message("Received message: " + msg);
-    StaticJsonBuffer<JSON_COMMAND_MAX_SIZE> jsonBuffer;
-    JsonObject &message_obj = jsonBuffer.parseObject(msg);
+	if (log_port != NULL) {
+		String msg;
+		message.printTo(msg);
+		log_message("Received message: " + msg);
+	}
 
 	String msg_request = message_queue.pop_front();
 	awaiting_response = false;
+	int retries = frame_retries;
+	frame_retries = 0;
 
-	if (!message_obj.success())
+	JsonSpan dd_local = message.get("/" DEVICEDRIVE_LOCAL);
+	JsonSpan dd_remote = message.get("/" DEVICEDRIVE_REMOTE);
+	JsonSpan configuration = message.get("/" CONFIGURATION);
+
+	if (!message.isObject())
         handleErrorMsg("Invalid JSON from WRF");
 
-	else if (message_obj.containsKey(DEVICEDRIVE_LOCAL))
+	else if (dd_local.success())
 	{	
-		JsonObject &dd_message = message_obj[DEVICEDRIVE_LOCAL].asObject();
-		if (dd_message.containsKey(DEVICEDRIVE_ERROR)) {
-			if (String(dd_message[DEVICEDRIVE_ERROR].asString()) == ERROR_SYSTEM_BUSY) {
+		JsonSpan error = dd_local.get("/" DEVICEDRIVE_ERROR);
+		if (error.success()) {
+			if (error.equals(ERROR_SYSTEM_BUSY)) {
+				// the WRF answers again when it is ready
 				awaiting_response = true;
 				message_queue.push_front(msg_request);
+				if (response_timeout != 0)
+					timers.start(TIMER_RESPONSE, current_time, response_timeout);
+			}
+			else if (error.equals(ERROR_INVALID_CRC) && retries < FRAME_RETRY_LIMIT) {
+				// the WRF received our frame damaged: send it again
+				frame_retries = retries + 1;
+				message_queue.push_front(msg_request);
 			}
 			else {
-				handleErrorMsg(message_obj[DEVICEDRIVE_LOCAL].asString());
+				String error_msg;
+				dd_local.printTo(error_msg);
+				handleErrorMsg(error_msg);
+				if (isImageRequest(msg_request))
+					abortImage("Image transfer failed");
 			}
 		}
-		if (dd_message.containsKey(DEVICEDRIVE_RESULT))
-			handleResultMsg(dd_message[DEVICEDRIVE_RESULT].asString());
-		if (dd_message.containsKey(DEVICEDRIVE_UPGRADE))
-			handleUpgradeMsg(dd_message[DEVICEDRIVE_UPGRADE].asArray());
-		if (dd_message.containsKey(DEVICEDRIVE_STATUS)) {
-			handleStatusMsg(dd_message[DEVICEDRIVE_STATUS].asObject());
+		JsonSpan result = dd_local.get("/" DEVICEDRIVE_RESULT);
+		if (result.success())
+			handleResultMsg(result);
+		JsonSpan upgrade = dd_local.get("/" DEVICEDRIVE_UPGRADE);
+		if (upgrade.success())
+			handleUpgradeMsg(upgrade);
+		JsonSpan image = dd_local.get("/" DEVICEDRIVE_IMAGE);
+		if (image.success())
+			handleImageMsg(image);
+		JsonSpan status = dd_local.get("/" DEVICEDRIVE_STATUS);
+		if (status.success()) {
+			handleStatusMsg(status);
 		}
 	}
-	else if (message_obj.containsKey(DEVICEDRIVE_REMOTE))
+	else if (dd_remote.success())
 	{
-		JsonObject &dd_message = message_obj[DEVICEDRIVE_REMOTE].asObject();
-		if (dd_message.containsKey(ERROR_CODE)) {
-			handleErrorMsg(message_obj[DEVICEDRIVE_REMOTE].asString());
+		if (dd_remote.get("/" ERROR_CODE).success()) {
+			String error_msg;
+			dd_remote.printTo(error_msg);
+			handleErrorMsg(error_msg);
 		}
 	}
-	else if (message_obj.containsKey(CONFIGURATION))
+	else if (configuration.success())
 	{
-		handleConfiguration(message_obj[CONFIGURATION].asObject());
+		handleConfiguration(configuration);
+	}
+}
+
+void WRF::handleSerialInput() {
+	if (receive_ring.isActive()) {
+		handleReceiveRing();
+		return;
+	}
+	while (serial->available() > 0) {
+		if (!handleSerialByte(serial->read()))
+			return;
+	}
+}
+
+// Returns false when the WRF restarts
+bool WRF::handleSerialByte(char data)
+{
+	bool restart = data == ETX_CHAR && last_received_char == STX_CHAR;
+	last_received_char = data;
+
+	// The bytes of an image chunk are counted, not decoded. STX ETX may be
+	// part of them: it is only taken for a restart if the chunk then stalls
+	// or is damaged
+	if (image_chunk_receiving) {
+		image_chunk_restart = image_chunk_restart || restart;
+		handleImageByte(data);
+		return true;
+	}
+	if (data == SOH_CHAR && image_chunk_requested && module_length == 0) {
+		image_chunk_receiving = true;
+		image_chunk_restart = false;
+		return true;
+	}
+
+	if (restart) {
+		handleRestart();
+		return false;
+	}
+
+	// With the frame check, a frame is kept until its CRC is verified
+	if (config.frame_check) {
+		if (data != EOT_CHAR)
+			appendModuleText(data);
+		else
+			handleCheckedFrame();
 	}
 	else
-	{
-		handleReceivedMessage(message_obj);
+		handleReceivedChar(data);
+	return true;
+}
+
+// The WRF needs its setup again, and the transfer of an image is
+// interrupted: it can be resumed from its saved state
+void WRF::handleRestart()
+{
+	resetReceivedMessage();
+	frame_check_active = false;
+	if (image_buffer != NULL)
+		abortImage("Image transfer interrupted");
+	triggerStartup();
+}
+
+// The ring only hands over complete frames, so a frame is never left half
+// decoded between two calls
+void WRF::handleReceiveRing()
+{
+	while (receive_ring.frameAvailable()) {
+		uint8_t flags = receive_ring.frameFlags();
+		bool restarted = false;
+		if (flags & RECEIVE_FRAME_DAMAGED)
+			handleLostFrame();
+		else if (!(flags & RECEIVE_FRAME_DISCARDED)) {
+			int data;
+			while (!restarted && (data = receive_ring.read()) >= 0)
+				restarted = !handleSerialByte(data);
+		}
+		receive_ring.nextFrame();
+		if (restarted)
+			return;
 	}
+}
 
-    
+void WRF::handleReceivedChar(char data)
+{
+	// The message is parsed while it arrives: messages for the interfaces
+	// are routed right away, the text of the others is kept in module_text
+	if (data != EOT_CHAR) {
+		stream_parser.parse(data);
+		if (!message_router.isRouting())
+			appendModuleText(data);
+	}
+	else
+		handleReceivedMessage();
 }
 
-void WRF::handleSerialInput() {
-	char last_char = 0x00;
-	while (serial->available() > 0) {
-		char data = serial->read();
-		
-		if (data == ETX_CHAR && received_message.endsWith(String(STX_CHAR))) {
-			received_message = "";
-			triggerStartup();
+// The message went through stream_parser, and its text is in module_text
+// unless it was routed
+void WRF::handleReceivedMessage()
+{
+	bool complete = stream_parser.finish();
+	// A module message is read from its text, so it doesn't matter if
+	// its tokens didn't fit on the heap
+	bool readable = complete || stream_parser.error().noMemory();
+	bool fits = isModuleTextComplete();
+	if (!message_router.isRouting())
+		recordReceivedSize(fits);
+
+	if (message_router.isRouting())
+		handleRoutedMessage(complete);
+	else if (!fits)
+		handleOversizedMessage();
+	else if (readable)
+		handleWrfMessage(JsonSpan(large_text != NULL ? large_text : module_text));
+	else
+		handleWrfMessage(JsonSpan());
+	resetReceivedMessage();
+}
+
+// With the frame check, the WRF ends each frame with US_CHAR and the CRC-32
+// of the payload in hexadecimal. A damaged frame is dropped before it is
+// parsed, so the frame is kept whole, up to max_message_size.
+// Until the WRF sends a checked frame, the frames without a trailer are
+// taken as they are. The first frame with a valid trailer turns the check on
+void WRF::handleCheckedFrame()
+{
+	char *text = large_text != NULL ? large_text : module_text;
+	if (!isModuleTextComplete()) {
+		recordReceivedSize(false);
+		handleOversizedMessage();
+		resetReceivedMessage();
+		return;
+	}
+
+	// a raw control character can't be part of the JSON
+	char *trailer = strrchr(text, US_CHAR);
+	if (trailer == NULL && !frame_check_active)
+		trailer = text + module_length;
+	else if (trailer == NULL || !checkFrameCrc(text, trailer - text, trailer + 1)) {
+		resetReceivedMessage();
+		handleCorruptFrame();
+		return;
+	}
+	else
+		frame_check_active = true;
+	module_length = trailer - text;
+	*trailer = '\0';
+
+	// The payload is parsed in place: messages for the interfaces are
+	// routed, the others are read from the text
+	stream_parser.parse(text, module_length);
+	handleReceivedMessage();
+}
+
+bool WRF::checkFrameCrc(const char *payload, size_t length, const char *trailer)
+{
+	uint32_t expected;
+	if (!parseFrameCrc(trailer, &expected))
+		return false;
+
+	Crc32 crc;
+	crc.update((const uint8_t *)payload, length);
+	return crc.value() == expected;
+}
+
+bool WRF::parseFrameCrc(const char *trailer, uint32_t *crc)
+{
+	if (strlen(trailer) != FRAME_CRC_DIGITS)
+		return false;
+	uint32_t expected = 0;
+	for (int i = 0; i < FRAME_CRC_DIGITS; i++) {
+		char c = trailer[i];
+		uint32_t digit;
+		if (c >= '0' && c <= '9')
+			digit = c - '0';
+		else if (c >= 'A' && c <= 'F')
+			digit = c - 'A' + 10;
+		else if (c >= 'a' && c <= 'f')
+			digit = c - 'a' + 10;
+		else
+			return false;
+		expected = (expected << 4) | digit;
+	}
+	*crc = expected;
+	return true;
+}
+
+// A damaged answer makes the WRF receive the command again, a few times,
+// instead of losing it
+// Bytes that didn't fit in the receive ring are lost like a damaged frame,
+// and the request is sent again
+void WRF::handleLostFrame()
+{
+	log_message("Received frame with lost bytes, " + String(receive_ring.lostBytes()) + " lost in total");
+	resetReceivedMessage();
+	if (awaiting_response && frame_retries < FRAME_RETRY_LIMIT) {
+		frame_retries++;
+		awaiting_response = false;
+		return;
+	}
+	String request;
+	if (awaiting_response) {
+		request = message_queue.pop_front();
+		awaiting_response = false;
+	}
+	frame_retries = 0;
+	handleErrorMsg("Message from WRF lost");
+	if (isImageRequest(request))
+		abortImage("Image transfer failed");
+}
+
+void WRF::handleCorruptFrame()
+{
+	log_message("Received frame with invalid CRC");
+	if (awaiting_response && frame_retries < FRAME_RETRY_LIMIT) {
+		frame_retries++;
+		awaiting_response = false;
+		return;
+	}
+	if (awaiting_response) {
+		message_queue.pop_front();
+		awaiting_response = false;
+	}
+	frame_retries = 0;
+	handleErrorMsg("Invalid CRC from WRF");
+}
+
+String WRF::appendFrameCrc(String frame)
+{
+	if (!frame_check_active)
+		return frame;
+	Crc32 crc;
+	crc.update((const uint8_t *)frame.c_str(), frame.length());
+	char trailer[FRAME_CRC_DIGITS + 2];
+	snprintf(trailer, sizeof(trailer), "%c%08lX", US_CHAR, (unsigned long)crc.value());
+	return frame + trailer;
+}
+
+// The WRF announces the image with its size and CRC-32, then sends each
+// chunk that is requested with get_image as SOH_CHAR, the raw bytes, and the
+// CRC-32 of the chunk in hexadecimal. The next chunk is requested as soon as
+// a half of image_buffer is free, so the link stays busy while the storage
+// writes, unless the storage stops the CPU while it writes: then only once
+// the previous chunk is written.
+// If the storage kept the state of a transfer of the same image, only the
+// chunks that are missing are requested.
+// A delta patch, announced with "delta":true, can't be resumed: it is
+// applied while it arrives.
+void WRF::handleImageMsg(const JsonSpan &image)
+{
+	if (image_buffer != NULL)
+		abortImage("Image transfer restarted");
+	if (image_storage == NULL) {
+		handleErrorMsg("No image storage");
+		return;
+	}
+
+	char item[STREAM_TOKEN_SIZE];
+	JsonVariant size = image.get("/size").toVariant(item, sizeof(item));
+	if (!size.success()) {
+		handleErrorMsg("Invalid image from WRF");
+		return;
+	}
+	image_size = size.as<unsigned long>();
+	JsonVariant crc = image.get("/crc").toVariant(item, sizeof(item));
+	const char *crc_text = crc.as<const char *>();
+	uint32_t image_crc = crc_text != NULL ? strtoul(crc_text, NULL, 16) : 0;
+	image_delta = image.get("/delta").toVariant(item, sizeof(item)).as<bool>();
+
+	image_chunk_count = (image_size + IMAGE_CHUNK_SIZE - 1) / IMAGE_CHUNK_SIZE;
+	image_state_size = sizeof(WrfImageState) + IMAGE_BITMAP_SIZE(image_chunk_count) + image_chunk_count * sizeof(uint32_t);
+	image_buffer = (uint8_t *)malloc(2 * IMAGE_CHUNK_SIZE);
+	image_state = (uint8_t *)malloc(image_state_size);
+	if (image_delta)
+		image_window = (uint8_t *)malloc(IMAGE_WINDOW_SIZE);
+	if (image_buffer == NULL || image_state == NULL || (image_delta && image_window == NULL)) {
+		releaseImage();
+		handleErrorMsg("Not enough memory for image");
+		return;
+	}
+
+	bool resume = !image_delta && loadImageState(image_size, image_crc);
+	if (resume && !image_storage->begin(image_size, true)) {
+		loadImageState(0, 0);
+		resume = false;
+	}
+	if (!resume) {
+		memset(image_state, 0xff, image_state_size);
+		WrfImageState *state = (WrfImageState *)image_state;
+		state->magic = IMAGE_STATE_MAGIC;
+		state->size = image_size;
+		state->crc = image_crc;
+		state->chunk_size = IMAGE_CHUNK_SIZE;
+	}
+	if (image_delta) {
+		// the storage begins with the size in the patch
+		image_patch.begin(image_storage);
+		image_output_crc.begin();
+	}
+	else if (!resume) {
+		if (!image_storage->begin(image_size, false)) {
+			releaseImage();
+			handleErrorMsg("Image too large for storage");
 			return;
 		}
-		last_char = data;
-		
-		if (data != EOT_CHAR) 
-			received_message += data;
-        else
-        {
-            handleWrfMessage(received_message);
-            received_message = "";
-        }
-	}
-}
-
-unsigned int * WRF::createCrcTable(void)
-{
-    unsigned int* crc_table;
-    unsigned int c;
-    unsigned int i, j;
-    crc_table = (unsigned int*)malloc(256 * 4);
-    for (i = 0; i < 256; i++) {
-        c = (unsigned int)i;
-        for (j = 0; j < 8; j++) {
-            if (c & 1)
-                c = 0xedb88320L ^ (c >> 1);
-            else
-                c = c >> 1;
-        }
-        crc_table[i] = c;
-    }
-    return crc_table;
+		image_storage->saveState(image_state, image_state_size);
+	}
+
+	image_missing = 0;
+	for (size_t chunk = 0; chunk < image_chunk_count; chunk++) {
+		if (isImageChunkMissing(chunk))
+			image_missing++;
+	}
+	log_message("Receiving image: " + String(image_size) + " bytes, " + String(image_missing) + " chunks missing");
+	if (image_missing == 0)
+		finishImage();
+	else
+		requestImageChunk();
 }
 
-unsigned int WRF::crc32(unsigned int crc, unsigned int* crc_table, unsigned char *buffer, unsigned int size)
+void WRF::handleImageByte(char data)
 {
-    unsigned int i;
-    for (i = 0; i < size; i++) {
-        crc = crc_table[(crc ^ buffer[i]) & 0xff] ^ (crc >> 8);
-    }
-    return crc ;
+	if (image_fill_length < image_chunk_length) {
+		image_buffer[image_fill_half * IMAGE_CHUNK_SIZE + image_fill_length++] = data;
+		return;
+	}
+	image_chunk_trailer[image_trailer_length++] = data;
+	if (image_trailer_length == FRAME_CRC_DIGITS)
+		handleImageChunk();
+}
+
+// The chunk is the answer to get_image. A damaged chunk is requested again,
+// a few times
+void WRF::handleImageChunk()
+{
+	last_received_char = 0x00;
+	image_chunk_receiving = false;
+	image_chunk_progress = 0;
+	timers.stop(TIMER_CHUNK);
+
+	Crc32 crc;
+	crc.update(image_buffer + image_fill_half * IMAGE_CHUNK_SIZE, image_fill_length);
+	image_chunk_trailer[image_trailer_length] = '\0';
+	uint32_t expected_crc;
+	bool valid = parseFrameCrc(image_chunk_trailer, &expected_crc) && crc.value() == expected_crc;
+	image_trailer_length = 0;
+
+	if (!valid && image_chunk_restart) {
+		handleRestart();
+		return;
+	}
+	if (!valid) {
+		log_message("Received image chunk with invalid CRC: " + String(image_chunk));
+		retryImageChunk("Invalid CRC from WRF");
+		return;
+	}
+
+	message_queue.pop_front();
+	awaiting_response = false;
+	frame_retries = 0;
+	image_chunk_requested = false;
+	image_chunk_retries = 0;
+	image_half_length[image_fill_half] = image_fill_length;
+	image_half_chunk[image_fill_half] = image_chunk;
+	image_half_crc[image_fill_half] = crc.value();
+	image_fill_length = 0;
+	image_fill_half = 1 - image_fill_half;
+
+	handleImageStorage();
+	requestImageChunk();
+}
+
+// A chunk that was damaged or cut is requested again, a few times
+void WRF::retryImageChunk(String error_msg)
+{
+	message_queue.pop_front();
+	awaiting_response = false;
+	frame_retries = 0;
+	image_chunk_requested = false;
+	image_fill_length = 0;
+	image_trailer_length = 0;
+	if (++image_chunk_retries > FRAME_RETRY_LIMIT) {
+		abortImage(error_msg);
+		return;
+	}
+	image_next_chunk = image_chunk;
+	requestImageChunk();
+}
+
+// Gives the full halves to the storage, for as long as it takes them without
+// waiting. A chunk is marked in the saved state once it is written
+void WRF::handleImageStorage()
+{
+	while (image_buffer != NULL && image_half_length[image_flush_half] != 0) {
+		size_t length = image_half_length[image_flush_half];
+		size_t chunk = image_half_chunk[image_flush_half];
+		const uint8_t *data = image_buffer + image_flush_half * IMAGE_CHUNK_SIZE + image_flushed;
+		int written;
+		if (image_delta)
+			written = applyImageDelta(data, length - image_flushed);
+		else
+			written = image_storage->write(chunk * IMAGE_CHUNK_SIZE + image_flushed, data, length - image_flushed);
+		if (written < 0) {
+			if (image_buffer != NULL)
+				abortImage("Image storage failed");
+			return;
+		}
+		if (written == 0)
+			return;
+
+		image_flushed += written;
+		if (image_flushed == length) {
+			markImageChunk(chunk, image_half_crc[image_flush_half]);
+			// not while the WRF sends a chunk: the storage may stop the CPU
+			if (image_state_unsaved >= IMAGE_STATE_INTERVAL && !image_chunk_requested)
+				saveImageState();
+			image_half_length[image_flush_half] = 0;
+			image_flush_half = 1 - image_flush_half;
+			image_flushed = 0;
+			if (image_missing == 0 && !image_delta) {
+				finishImage();
+				return;
+			}
+			requestImageChunk();
+		}
+	}
+	if (image_buffer != NULL && image_delta && image_missing == 0) {
+		int finished = finishImageDelta();
+		if (finished < 0 && image_buffer != NULL)
+			abortImage("Image storage failed");
+		else if (finished > 0)
+			finishImage();
+		return;
+	}
+	// the storage may have been busy when the last chunk was written
+	requestImageChunk();
+}
+
+void WRF::requestImageChunk()
+{
+	if (image_buffer == NULL || image_chunk_requested || image_half_length[image_fill_half] != 0)
+		return;
+	if (!image_storage->canReceiveWhileBusy()
+		&& (image_half_length[image_flush_half] != 0 || image_storage->isBusy()))
+		return;
+	while (image_next_chunk < image_chunk_count && !isImageChunkMissing(image_next_chunk))
+		image_next_chunk++;
+	if (image_next_chunk == image_chunk_count)
+		return;
+
+	image_chunk = image_next_chunk++;
+	size_t offset = image_chunk * IMAGE_CHUNK_SIZE;
+	image_chunk_length = image_size - offset;
+	if (image_chunk_length > IMAGE_CHUNK_SIZE)
+		image_chunk_length = IMAGE_CHUNK_SIZE;
+	image_chunk_requested = true;
+	Dictionary params = {
+		{ "offset", String(offset) },
+		{ "length", String(image_chunk_length) },
+		END_OF_DICTIONARY
+	};
+	sendCommand(COMMAND_GET_IMAGE, params);
+}
+
+// Returns true if the saved state is the one of this image.
+// With a size of 0, invalidates the saved state instead
+bool WRF::loadImageState(size_t size, uint32_t crc)
+{
+	WrfImageState *state = (WrfImageState *)image_state;
+	if (size == 0) {
+		state->magic = 0;
+		image_storage->saveState(image_state, sizeof(WrfImageState));
+		return false;
+	}
+	return image_storage->loadState(image_state, image_state_size) == image_state_size
+		&& state->magic == IMAGE_STATE_MAGIC && state->size == size && state->crc == crc
+		&& state->chunk_size == IMAGE_CHUNK_SIZE;
+}
+
+// Saves the chunks marked since the last time
+void WRF::saveImageState()
+{
+	if (image_delta || image_state_unsaved == 0)
+		return;
+	image_storage->saveState(image_state, image_state_size);
+	image_state_unsaved = 0;
+}
+
+// The bits of the missing chunks are set, and the CRC of a missing chunk is
+// 0xffffffff, so that receiving a chunk only clears bits
+bool WRF::isImageChunkMissing(size_t chunk)
+{
+	const uint8_t *bitmap = image_state + sizeof(WrfImageState);
+	return bitmap[chunk / 8] & (1 << (chunk % 8));
+}
+
+void WRF::markImageChunk(size_t chunk, uint32_t crc)
+{
+	uint8_t *bitmap = image_state + sizeof(WrfImageState);
+	uint32_t *chunk_crcs = (uint32_t *)(bitmap + IMAGE_BITMAP_SIZE(image_chunk_count));
+	if (isImageChunkMissing(chunk))
+		image_missing--;
+	chunk_crcs[chunk] = crc;
+	bitmap[chunk / 8] &= ~(1 << (chunk % 8));
+	image_state_unsaved++;
+}
+
+// The CRC of the image is combined from the CRCs of the chunks, since they
+// may have been received in several transfers
+void WRF::finishImage()
+{
+	const uint32_t *chunk_crcs = (const uint32_t *)(image_state + sizeof(WrfImageState) + IMAGE_BITMAP_SIZE(image_chunk_count));
+	uint32_t crc = 0;
+	for (size_t chunk = 0; chunk < image_chunk_count; chunk++) {
+		size_t length = image_size - chunk * IMAGE_CHUNK_SIZE;
+		crc = Crc32::combine(crc, chunk_crcs[chunk], length < IMAGE_CHUNK_SIZE ? length : IMAGE_CHUNK_SIZE);
+	}
+	bool valid = crc == ((WrfImageState *)image_state)->crc;
+	if (valid)
+		saveImageState();
+	if (image_delta)
+		valid = valid && image_patch.finished() && image_output_crc.value() == image_patch.targetCrc();
+	bool stored = image_storage->end();
+	if (!valid && !image_delta)
+		loadImageState(0, 0);
+	releaseImage();
+
+	if (!stored)
+		handleErrorMsg("Image storage failed");
+	else if (!valid)
+		handleErrorMsg("Invalid image CRC");
+	else {
+		log_message("Image received");
+		if (image_received_cb != NULL)
+			image_received_cb();
+	}
+}
+
+// Returns the number of bytes of the patch used, 0 while the storage is busy,
+// or -1 on failure
+int WRF::applyImageDelta(const uint8_t *patch, size_t size)
+{
+	int written = writeImageWindow();
+	if (written <= 0)
+		return written;
+
+	bool had_header = image_patch.hasHeader();
+	size_t length;
+	size_t used = image_patch.apply(patch, size, image_window, IMAGE_WINDOW_SIZE, &length);
+	if (image_patch.failed()) {
+		abortImage("Invalid delta patch");
+		return -1;
+	}
+	if (!had_header && image_patch.hasHeader() && !startImageDelta())
+		return -1;
+
+	image_output_crc.update(image_window, length);
+	image_window_length = length;
+	image_window_written = 0;
+	if (writeImageWindow() < 0)
+		return -1;
+	return used;
+}
+
+// Returns 1 once the window is written, 0 while the storage is busy, or -1
+// on failure
+int WRF::writeImageWindow()
+{
+	while (image_window_written < image_window_length) {
+		int written = image_storage->write(image_output_offset,
+			image_window + image_window_written, image_window_length - image_window_written);
+		if (written <= 0)
+			return written;
+		image_window_written += written;
+		image_output_offset += written;
+	}
+	return 1;
+}
+
+// The patch must be made for the current image
+bool WRF::startImageDelta()
+{
+	Crc32 crc;
+	size_t size = image_patch.sourceSize();
+	for (size_t offset = 0; offset < size; offset += IMAGE_WINDOW_SIZE) {
+		size_t length = size - offset < IMAGE_WINDOW_SIZE ? size - offset : IMAGE_WINDOW_SIZE;
+		if (image_storage->readCurrent(offset, image_window, length) != length)
+			break;
+		crc.update(image_window, length);
+	}
+	if (crc.length() != size || crc.value() != image_patch.sourceCrc()) {
+		abortImage("Delta patch not made for the current image");
+		return false;
+	}
+	if (!image_storage->begin(image_patch.targetSize(), false)) {
+		abortImage("Image too large for storage");
+		return false;
+	}
+	log_message("Applying delta patch: " + String(image_patch.targetSize()) + " bytes");
+	return true;
+}
+
+// Once the whole patch is applied, produces the rest of the new image, a
+// window per call, so that loopHandler() doesn't wait for the storage.
+// Returns 1 once it is written, 0 until then, and -1 on a failure
+int WRF::finishImageDelta()
+{
+	int written = writeImageWindow();
+	if (written <= 0)
+		return written;
+
+	size_t length;
+	image_patch.apply(NULL, 0, image_window, IMAGE_WINDOW_SIZE, &length);
+	if (image_patch.failed()) {
+		abortImage("Invalid delta patch");
+		return -1;
+	}
+	if (length == 0)
+		return 1;
+	image_output_crc.update(image_window, length);
+	image_window_length = length;
+	image_window_written = 0;
+	return writeImageWindow() < 0 ? -1 : 0;
+}
+
+// The saved state is kept, to resume the transfer
+void WRF::abortImage(String error_msg)
+{
+	if (image_buffer != NULL) {
+		saveImageState();
+		image_storage->end();
+	}
+	releaseImage();
+	handleErrorMsg(error_msg);
+}
+
+void WRF::releaseImage()
+{
+	free(image_buffer);
+	image_buffer = NULL;
+	free(image_state);
+	image_state = NULL;
+	free(image_window);
+	image_window = NULL;
+	image_window_length = image_window_written = image_output_offset = 0;
+	image_delta = false;
+	image_half_length[0] = image_half_length[1] = 0;
+	image_fill_half = image_flush_half = 0;
+	image_fill_length = image_flushed = 0;
+	image_size = image_chunk_count = image_missing = image_next_chunk = 0;
+	image_state_unsaved = 0;
+	image_trailer_length = 0;
+	image_chunk_retries = 0;
+	image_chunk_requested = false;
+	image_chunk_receiving = false;
+	image_chunk_progress = 0;
+	timers.stop(TIMER_CHUNK);
+}
+
+// A message for the cloud, not a command of the WRF
+bool WRF::hasQueuedMessage()
+{
+	for (int i = 0; i < message_queue.count(); i++) {
+		if (!isCommand(message_queue.at(i)))
+			return true;
+	}
+	return false;
+}
+
+bool WRF::isCommand(const String &request)
+{
+	return request.startsWith("{\"devicedrive\"");
 }
 
-/* Replace this function with your implementation */
+bool WRF::isImageRequest(const String &request)
+{
+	return request.indexOf("\"" COMMAND_GET_IMAGE "\"") >= 0;
+}
+
+void WRF::handleRoutedMessage(bool complete)
+{
+	log_message("Received routed message");
+	message_queue.pop_front();
+	awaiting_response = false;
+	frame_retries = 0;
+
+	// someone uses the app: the next messages are expected soon
+	if (complete) {
+		current_poll_interval = pollInterval;
+		restartPollTimer();
+	}
+
+	if (!complete && stream_parser.error().noMemory())
+		handleErrorMsg("Message from WRF too large");
+	else if (!complete)
+		handleErrorMsg("Invalid JSON from WRF");
+}
+
+// Unlike a message that is invalid, a message that is too large can't be
+// read at all: it is reported without its content
+void WRF::handleOversizedMessage()
+{
+	log_message("Received message too large: " + String(module_length) + " bytes");
+	message_queue.pop_front();
+	awaiting_response = false;
+	frame_retries = 0;
+	handleErrorMsg("Message from WRF too large");
+}
+
+// The messages that don't fit in module_text are moved to the heap, where the
+// text doubles until max_message_size, so that module_text only needs to fit
+// the common messages.
+// The length keeps counting when the message doesn't fit, so that the
+// memory stats tell how much it needed
+void WRF::appendModuleText(char data)
+{
+	size_t capacity = large_text == NULL ? sizeof(module_text) : large_text_capacity;
+	if (module_length + 1 == capacity)
+		capacity = growModuleText(capacity);
+	if (module_length + 1 < capacity) {
+		char *text = large_text == NULL ? module_text : large_text;
+		text[module_length] = data;
+		text[module_length + 1] = '\0';
+	}
+	module_length++;
+}
+
+// Returns the new capacity, or the same one if the text can't grow
+size_t WRF::growModuleText(size_t capacity)
+{
+	size_t new_capacity = capacity * 2;
+	if (new_capacity > max_message_size)
+		new_capacity = max_message_size;
+	if (new_capacity <= capacity)
+		return capacity;
+
+	char *text = (char *)realloc(large_text, new_capacity);
+	if (text == NULL)
+		return capacity;
+	if (large_text == NULL)
+		memcpy(text, module_text, capacity);
+	large_text = text;
+	large_text_capacity = new_capacity;
+	return new_capacity;
+}
+
+bool WRF::isModuleTextComplete()
+{
+	return module_length < (large_text == NULL ? sizeof(module_text) : large_text_capacity);
+}
+
+void WRF::recordReceivedSize(bool fits)
+{
+	if (module_length > memory_stats.received_size)
+		memory_stats.received_size = module_length;
+	if (module_length >= sizeof(module_text))
+		memory_stats.received_spills++;
+	if (!fits)
+		memory_stats.received_overflows++;
+}
+
+void WRF::recordCommandMemory(const StaticJsonBuffer<JSON_COMMAND_MAX_SIZE> &buffer)
+{
+	if (buffer.size() > memory_stats.command_size)
+		memory_stats.command_size = buffer.size();
+#if ARDUINOJSON_ENABLE_MEMORY_STATS
+	const JsonBufferStats &stats = buffer.stats();
+	if (stats.nodeBytes > memory_stats.command_node_size)
+		memory_stats.command_node_size = stats.nodeBytes;
+	if (stats.stringBytes > memory_stats.command_string_size)
+		memory_stats.command_string_size = stats.stringBytes;
+	memory_stats.command_failed_allocations += stats.failedAllocations;
+#endif
+}
+
+void WRF::resetReceivedMessage()
+{
+	stream_parser.reset();
+	message_router.reset();
+	module_length = 0;
+	module_text[0] = '\0';
+	free(large_text);
+	large_text = NULL;
+	large_text_capacity = 0;
+}
+
+// The register before the final inversion, as the WRF expects it
 unsigned int WRF::calcCrc(unsigned char* buffer, int size)
 {
-	log_message("Length: ");
-	log_message(len);
-    unsigned int *crc_table = createCrcTable();
-    unsigned int crc = 0xffffffff;
-    crc = crc32(crc, crc_table, buffer, size);
-    free(crc_table);
-    return crc;
+	return Crc32::update(Crc32::INITIAL, buffer, size);
 }
 
 void WRF::log_message(String msg)
@@ -633,19 +1627,27 @@ String WRF::serializeConfigData(WRFConfig &config) {
 	command["product_key"] = product_key;
 	command["version"] = version;
 	command["ssl_enabled"] = (config.ssl_enabled ? "1" : "0");
+	if (config.frame_check)
+		command["frame_check"] = "crc32";
     String result;
 	root.printTo(result);
+	recordCommandMemory(jsonBuffer);
     return result;
 }
 
 
-JsonObject& WRF::deserialize(String msg){
-  msg.trim();
-  msg.replace("\n", "");
-  msg.replace(" ", "");
-  msg.replace("\t", "");
-  StaticJsonBuffer<JSON_COMMAND_MAX_SIZE> jsonBuffer;
-  return jsonBuffer.parseObject(msg.c_str());
+// The introspect is usually written on several lines, in a macro: the
+// spaces and tabs of the indentation would be sent with each command
+String WRF::minify(const String &json)
+{
+	char *text = (char *)malloc(json.length() + 1);
+	if (text == NULL)
+		return json;
+	json.toCharArray(text, json.length() + 1);
+	minifyJson(text);
+	String result(text);
+	free(text);
+	return result;
 }
 
 void WRF::merge(JsonObject& dest, JsonObject& src) {
@@ -20,6 +20,12 @@
 #include "WRFConfig.h"
 #include "ArduinoJson/ArduinoJson.h"
 #include "StringQueue.h"
+#include "Crc32.h"
+#include "ImageStorage.h"
+#include "DeltaPatch.h"
+#include "Timers.h"
+#include "ReceiveRing.h"
+#include "MessageRouter.h"
 
 #define MAX_DICTIONARY_SIZE 8
 #define MAX_LIST_SIZE 8
@@ -29,11 +35,27 @@ typedef String List[MAX_LIST_SIZE + 1];
 
 typedef void WrfCallback();
 typedef void WrfStartUpCallback(WRFConfig &config);
-typedef void WrfMessageReceivedCallback(String interfaceName, String json_string);
 typedef void WrfErrorCallback(String errorMessage);
 typedef void WrfUpgradeCallback(List &pending_upgrades);
 
+// The most memory the messages needed since startup, or since
+// resetMemoryStats(), to compare with MODULE_TEXT_SIZE and
+// JSON_COMMAND_MAX_SIZE.
+// The node and string sizes, and the failed allocations, need ArduinoJson's
+// memory stats: build with ARDUINOJSON_ENABLE_MEMORY_STATS=1.
+typedef struct {
+	size_t received_size;             // longest message for the module
+	unsigned int received_spills;     // messages longer than MODULE_TEXT_SIZE, kept on the heap
+	unsigned int received_overflows;  // messages longer than the max message size
+	size_t command_size;              // JsonBuffer of sendCommand() and setup()
+	size_t command_node_size;         // ...used by objects and arrays
+	size_t command_string_size;       // ...used by copies of strings
+	unsigned int command_failed_allocations;
+} WrfMemoryStats;
+
 #define PROTOCOL_RAW "RAW"
+#define PROTOCOL_CHUNKED "CHUNKED"
+#define PROTOCOL_DELTA "DELTA"
 #define DEFAULT_PROTOCOL PROTOCOL_RAW
 #define DEFAULT_TOGGLE ""
 #define DEFAULT_DELAY 0
@@ -41,28 +63,66 @@ typedef void WrfUpgradeCallback(List &pending_upgrades);
 #define END_OF_LIST ""
 #define END_OF_DICTIONARY {END_OF_LIST,END_OF_LIST}
 #define SEND_QUEUE_LEN 10
+#define JSON_COMMAND_MAX_SIZE 512
+#define MODULE_TEXT_SIZE 256
+#define DEFAULT_MESSAGE_MAX_SIZE 1024
+// The keys and strings of the routed messages that are longer move to the
+// heap, up to the size of the message
+#define STREAM_TOKEN_SIZE 128
+
+// A multiple of the flash rows (256 bytes), so that each chunk is erased
+// with its own rows
+#ifndef IMAGE_CHUNK_SIZE
+#define IMAGE_CHUNK_SIZE 512
+#endif
+#define IMAGE_WINDOW_SIZE 256
+// Saving the state of a transfer stops the CPU on the SAMD21, so it is only
+// saved every few chunks: a resumed transfer receives these again
+#ifndef IMAGE_STATE_INTERVAL
+#define IMAGE_STATE_INTERVAL 8
+#endif
 
+#define SOH_CHAR ((char)0x01)
 #define STX_CHAR ((char)0x02)
 #define ETX_CHAR ((char)0x03)
 #define EOT_CHAR ((char)0x04)
+#define US_CHAR ((char)0x1F)
+
+#define FRAME_CRC_DIGITS 8
+#define FRAME_RETRY_LIMIT 2
+// The WRF sends a chunk without pauses: a chunk that doesn't grow for this
+// long lost a byte, and is requested again
+#define IMAGE_BYTE_TIMEOUT 100
+
+// An answer isn't matched to its command: a late answer would be taken for
+// the answer of the command sent again, so the timeout is off by default
+#define DEFAULT_RESPONSE_TIMEOUT 0
 
 class WRF
 {
 	public:
 		WRF(HardwareSerial *serial, String version, String product_Key, String introspect, HardwareSerial *logPort = NULL, int pollInterval = 0);
 		void setup(WRFConfig &config);
-		void loopHandler();
+		unsigned long loopHandler();
 
 		void setupParam(String param, String value);
         void connect();
 		void prepareLinkupMode(int vivibility_seconds);
 
 		void poll();
-		void setPollInterval(int seconds);
+		void setPollInterval(int seconds, int max_seconds = 0);
+		void setResponseTimeout(unsigned long timeout_millis);
+#if defined(ARDUINO_ARCH_SAMD)
+		bool useReceiveInterrupt(IRQn_Type irq, size_t size = RECEIVE_RING_SIZE);
+#endif
+#if defined(__linux__)
+		bool useReceiveThread(size_t size = RECEIVE_RING_SIZE);
+#endif
 		
 		void checkPendingUpgrades();
 		void startWrfUpgrade();
 		void startClientUpgrade(int file_no = DEFAULT_FILE_NO, String protocol = DEFAULT_PROTOCOL, int delay_millis = DEFAULT_DELAY, String toggle_pattern = DEFAULT_TOGGLE);
+		void setImageStorage(ImageStorage *image_storage);
 
 		void send(String raw_string);
 		bool canSendCommand();
@@ -83,11 +143,16 @@ class WRF
 		void onMessageSent(WrfCallback *message_sent_cb);
 		void overrideOnStart(WrfStartUpCallback *start_cb);
 		void onMessageReceived(WrfMessageReceivedCallback *message_received_connection_cb);
+		void onMessageStream(JsonHandler *stream_handler);
 		void onPendingUpgrades(WrfUpgradeCallback *pending_upgrades_cb);
 		void onNotConnected(WrfCallback *not_connected_cb);
 		void onStatusReceived(WrfMessageReceivedCallback *status_received_cb);
+		void onImageReceived(WrfCallback *image_received_cb);
 
+		void setMaxMessageSize(size_t size);
 		void clearMessageQueue();
+		WrfMemoryStats getMemoryStats();
+		void resetMemoryStats();
         int getListSize(List & list);
         void addToList(List & list, String item);
         void addToDictionary(Dictionary & dictionary, String key, String value);
@@ -101,6 +166,7 @@ class WRF
         WrfMessageReceivedCallback *message_received_cb = NULL;
 		WrfMessageReceivedCallback *status_received_cb = NULL;
         WrfUpgradeCallback *pending_upgrades_cb = NULL;
+		WrfCallback *image_received_cb = NULL;
 
         bool is_connected = false;
 		bool is_visible = false;
@@ -111,47 +177,140 @@ class WRF
 		int baud_rate;
 		StringQueue message_queue;
 
-		int len = 0;
 		String introspect;
         String version;
 
-		int crc_wrf;
 		HardwareSerial * serial;
 		HardwareSerial * log_port;
-		String received_message;
+		char last_received_char = 0x00;
+		char module_text[MODULE_TEXT_SIZE];
+		size_t module_length = 0;
+		char *large_text = NULL;
+		size_t large_text_capacity = 0;
+		size_t max_message_size = DEFAULT_MESSAGE_MAX_SIZE;
+		bool frame_check_active = false;
+		int frame_retries = 0;
+		WrfMemoryStats memory_stats = {};
+		MessageRouter message_router;
+		JsonStreamParser<STREAM_TOKEN_SIZE> stream_parser;
+
+		// The client image is received in two halves of image_buffer: one is
+		// written to the storage while the next chunk fills the other, if the
+		// storage can receive while busy.
+		// image_state tells which chunks are missing, with the CRC of the
+		// others, and is saved by the storage
+		ImageStorage *image_storage = NULL;
+		uint8_t *image_buffer = NULL;
+		uint8_t *image_state = NULL;
+		size_t image_state_size = 0;
+		size_t image_state_unsaved = 0;
+		size_t image_half_length[2] = {};
+		size_t image_half_chunk[2] = {};
+		uint32_t image_half_crc[2] = {};
+		int image_fill_half = 0;
+		size_t image_fill_length = 0;
+		int image_flush_half = 0;
+		size_t image_flushed = 0;
+		size_t image_size = 0;
+		size_t image_chunk_count = 0;
+		size_t image_missing = 0;
+		size_t image_next_chunk = 0;
+		size_t image_chunk = 0;
+		size_t image_chunk_length = 0;
+		char image_chunk_trailer[FRAME_CRC_DIGITS + 1];
+		size_t image_trailer_length = 0;
+		int image_chunk_retries = 0;
+		bool image_chunk_requested = false;
+		bool image_chunk_receiving = false;
+		bool image_chunk_restart = false;
+		size_t image_chunk_progress = 0;
+
+		// A delta patch is applied to the current image while it arrives, and
+		// the new image goes to the storage through image_window
+		bool image_delta = false;
+		DeltaPatch image_patch;
+		uint8_t *image_window = NULL;
+		size_t image_window_length = 0;
+		size_t image_window_written = 0;
+		size_t image_output_offset = 0;
+		Crc32 image_output_crc;
 		void log_message(String msg);
 		void log_message(int data);
 
 		unsigned long pollInterval = 0;
+		unsigned long max_poll_interval = 0;
+		unsigned long current_poll_interval = 0;
 		unsigned long current_time = 0;
-		unsigned long previous_time = 0;
+		unsigned long response_timeout = DEFAULT_RESPONSE_TIMEOUT;
+		Timers timers;
+		ReceiveRing receive_ring;
 
 		unsigned long awaiting_linkup = false;
-		unsigned long linkup_timeout = 0;
 
 
 		void automaticPoll();
+		void restartPollTimer();
 		void triggerSentMessage();
 		void handleMessageQueue();
 		void triggerStartup();
 		void handleStartup(WRFConfig &config);
-        void handleConfiguration(JsonObject &configuration);
-        void handleResultMsg(String result);
-        void handleReceivedMessage(JsonObject &message_obj);
-        void handleUpgradeMsg(JsonArray & message_obj);
-        void handleWrfMessage(String & msg);
+        void handleConfiguration(const JsonSpan &configuration);
+        void handleResultMsg(const JsonSpan &result);
+        void handleUpgradeMsg(const JsonSpan &pending_upgrades);
+		void handleImageMsg(const JsonSpan &image);
+		void handleImageByte(char data);
+		void handleImageChunk();
+		void retryImageChunk(String error_msg);
+		size_t receivedChunkLength();
+		void handleImageStorage();
+		void requestImageChunk();
+		bool loadImageState(size_t size, uint32_t crc);
+		void saveImageState();
+		bool isImageChunkMissing(size_t chunk);
+		void markImageChunk(size_t chunk, uint32_t crc);
+		void finishImage();
+		int applyImageDelta(const uint8_t *patch, size_t size);
+		int writeImageWindow();
+		bool startImageDelta();
+		int finishImageDelta();
+		void abortImage(String error_msg);
+		void releaseImage();
+		bool hasQueuedMessage();
+		static bool isCommand(const String &request);
+		static bool isImageRequest(const String &request);
+        void handleWrfMessage(const JsonSpan &message);
         void handleSerialInput();
+		bool handleSerialByte(char data);
+		void handleRestart();
+		void handleReceiveRing();
+		void handleReceivedChar(char data);
+		void handleReceivedMessage();
+		void handleCheckedFrame();
+		void handleCorruptFrame();
+		void handleLostFrame();
+		bool checkFrameCrc(const char *payload, size_t length, const char *trailer);
+		static bool parseFrameCrc(const char *trailer, uint32_t *crc);
+		String appendFrameCrc(String frame);
+		void handleRoutedMessage(bool complete);
+		void handleOversizedMessage();
+		void appendModuleText(char data);
+		size_t growModuleText(size_t capacity);
+		bool isModuleTextComplete();
+		void recordReceivedSize(bool fits);
+		void recordCommandMemory(const StaticJsonBuffer<JSON_COMMAND_MAX_SIZE> &buffer);
+		void resetReceivedMessage();
 		void handleErrorMsg(String error_msg);
-		void handleStatusMsg(JsonObject& status_object);
+		void handleStatusMsg(const JsonSpan &status);
 		void handleAutomaticPoll();
 		void handleLinkupTimeout();
-        JsonObject& deserialize(String msg);
+		void handleResponseTimeout();
+		void handleChunkTimeout();
+		unsigned long nextDeadline();
+		static String minify(const String &json);
 		String serializeConfigData(WRFConfig &config);
 		String generateIntrospectDocument();
 		
 		
-		unsigned int* createCrcTable(void);
-		unsigned int crc32(unsigned int crc, unsigned int* crc_table, unsigned char* buffer, unsigned int size);
 		unsigned int calcCrc(unsigned char* buffer, int size);
 		static void merge(JsonObject& dest, JsonObject& src);
 };
@@ -31,4 +31,8 @@ struct WRFConfig {
   ErrorMode error_mode = ERROR_ALL;
   String ssid_prefix = "DeviceDrive";
   bool ssl_enabled = true;
+  // Asks the WRF to add a CRC-32 to each frame, and checks it. Needs a WRF
+  // firmware that supports it: until the WRF sends a checked frame, the
+  // frames stay plain.
+  bool frame_check = false;
 };